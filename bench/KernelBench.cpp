@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AABB.h"
+#include "BVHNode.h"
+#include "Camera.h"
+#include "Color.h"
+#include "LinearBVH.h"
+#include "Random.h"
+#include "Ray.h"
+#include "Sphere.h"
+#include "SyntheticScene.h"
+#include "Triangle.h"
+#include "WideBVH.h"
+
+// Times the intersection, traversal and color kernels in isolation, in ns per call
+
+using namespace std::chrono;
+
+static double minSeconds = .2; // per timing run, the best of a few runs is kept
+static volatile double sink;   // keeps results alive so the calls aren't optimized away
+
+// Calls kernel(i) for every input until minSeconds pass, best of three runs
+template <typename Kernel>
+static double timeKernel(size_t inputs, Kernel&& kernel) {
+    double best = DBL_MAX;
+    for (int run = 0; run < 3; ++run) {
+        double sum = 0, elapsed = 0;
+        size_t calls = 0;
+        auto start = steady_clock::now();
+        while (elapsed < minSeconds) {
+            for (size_t i = 0; i < inputs; ++i) sum += kernel(i);
+            calls += inputs;
+            elapsed = duration<double>(steady_clock::now() - start).count();
+        }
+        sink = sum;
+        best = std::min(best, elapsed * 1e9 / calls);
+    }
+    return best;
+}
+
+static void report(const std::string& kernel, const std::string& variant, double ns) {
+    std::cout << std::left << std::setw(36) << kernel << std::setw(26) << variant << std::right << std::fixed << std::setprecision(2) << std::setw(10) << ns << "\n";
+}
+
+static Vector3d randomDirection(PCG32& rng) {
+    // Normalized point in the unit ball, rejecting the corners of the cube
+    while (true) {
+        Vector3d v(rng.nextFloat() * 2 - 1, rng.nextFloat() * 2 - 1, rng.nextFloat() * 2 - 1);
+        double lengthSquared = v.lengthSquared();
+        if (lengthSquared > 1e-4 && lengthSquared <= 1) return v / std::sqrt(lengthSquared);
+    }
+}
+
+static Vector3 randomPoint(PCG32& rng, float extent) {
+    return Vector3((rng.nextFloat() * 2 - 1) * extent, (rng.nextFloat() * 2 - 1) * extent, (rng.nextFloat() * 2 - 1) * extent);
+}
+
+// Rays from around the origin toward it, so roughly half hit what is placed there
+static std::vector<Ray> makeRays(PCG32& rng, size_t count) {
+    std::vector<Ray> rays;
+    for (size_t i = 0; i < count; ++i) {
+        Vector3d origin = randomDirection(rng) * 3.0;
+        Vector3d target = Vector3d(randomPoint(rng, 1));
+        rays.emplace_back(origin, (target - origin).normalized());
+    }
+    return rays;
+}
+
+template <int Width>
+static std::vector<WideBVHNode<Width>> makeWideNodes(PCG32& rng, size_t count) {
+    std::vector<WideBVHNode<Width>> nodes(count);
+    for (WideBVHNode<Width>& node : nodes) {
+        node.childCount = Width;
+        for (int i = 0; i < Width; ++i) {
+            Vector3 center = randomPoint(rng, 1), half = Vector3(.1f, .1f, .1f) + randomPoint(rng, .1f);
+            node.lowerX[i] = center.x - std::abs(half.x);
+            node.lowerY[i] = center.y - std::abs(half.y);
+            node.lowerZ[i] = center.z - std::abs(half.z);
+            node.upperX[i] = center.x + std::abs(half.x);
+            node.upperY[i] = center.y + std::abs(half.y);
+            node.upperZ[i] = center.z + std::abs(half.z);
+            node.child[i] = 0;
+            node.count[i] = 0;
+        }
+    }
+    return nodes;
+}
+
+template <int Width>
+static void benchWideNodes(PCG32& rng, const std::vector<Ray>& rays, const std::string& simdName) {
+    std::vector<WideBVHNode<Width>> nodes = makeWideNodes<Width>(rng, rays.size());
+    std::vector<float> origins, invDirs;
+    for (const Ray& ray : rays) {
+        origins.insert(origins.end(), { (float)ray.origin.x, (float)ray.origin.y, (float)ray.origin.z });
+        invDirs.insert(invDirs.end(), { (float)ray.invDirection.x, (float)ray.invDirection.y, (float)ray.invDirection.z });
+    }
+
+    std::string kernel = "WideBVH<" + std::to_string(Width) + ">::intersectChildren";
+    alignas(32) float tNear[Width];
+    report(kernel, "float scalar", timeKernel(nodes.size(), [&](size_t i) {
+        return WideBVH<Width>::intersectChildrenScalar(nodes[i], &origins[i * 3], &invDirs[i * 3], FLT_MAX, tNear);
+    }));
+    report(kernel, "float " + simdName, timeKernel(nodes.size(), [&](size_t i) {
+        return WideBVH<Width>::intersectChildren(nodes[i], &origins[i * 3], &invDirs[i * 3], FLT_MAX, tNear);
+    }));
+}
+
+static void benchTraversal(const Accelerator& bvh, const std::string& variant, const std::vector<Ray>& coherent, const std::vector<Ray>& incoherent) {
+    auto intersect = [&](const std::vector<Ray>& rays) {
+        return [&bvh, &rays](size_t i) {
+            HitRecord hit;
+            int checks = 0;
+            return bvh.intersect(rays[i], hit, checks) ? hit.t : 0.0;
+        };
+    };
+    report("Accelerator::intersect", variant + " coherent", timeKernel(coherent.size(), intersect(coherent)));
+    report("Accelerator::intersect", variant + " incoherent", timeKernel(incoherent.size(), intersect(incoherent)));
+    report("Accelerator::occluded", variant + " incoherent", timeKernel(incoherent.size(), [&](size_t i) {
+        int checks = 0;
+        return (double)bvh.occluded(incoherent[i], 0, DBL_MAX, checks);
+    }));
+}
+
+static const char* USAGE =
+    "Usage: pathtracer_microbench [--min-time s] [--triangles n]\n"
+    "  --min-time s    length of each timing run, .2 by default\n"
+    "  --triangles n   size of the mesh traversed, 100000 by default\n";
+
+int main(int argc, char** argv) {
+    int triangles = 100000;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--min-time" && i + 1 < argc) minSeconds = std::stod(argv[++i]);
+        else if (argument == "--triangles" && i + 1 < argc) triangles = std::stoi(argv[++i]);
+        else {
+            std::cout << USAGE;
+            return argument == "--help" || argument == "-h" ? 0 : 1;
+        }
+    }
+
+    constexpr size_t INPUTS = 4096; // small enough to stay in cache, so only the kernel is timed
+    PCG32 rng(0);
+    std::vector<Ray> rays = makeRays(rng, INPUTS);
+
+    std::cout << std::left << std::setw(36) << "kernel" << std::setw(26) << "variant" << std::right << std::setw(10) << "ns/op" << "\n" << std::string(72, '-') << "\n";
+
+    // Boxes
+    std::vector<AABB> boxes;
+    for (size_t i = 0; i < INPUTS; ++i) {
+        Vector3 center = randomPoint(rng, 1), half(.2f, .2f, .2f);
+        boxes.push_back({ center - half, center + half });
+    }
+    report("AABB::rayHit", "double scalar", timeKernel(INPUTS, [&](size_t i) {
+        double t = 0;
+        return boxes[i].rayHit(rays[i], t) ? t : 0.0;
+    }));
+#if defined(__SSE2__) || defined(_M_X64)
+    benchWideNodes<4>(rng, rays, "sse");
+#else
+    benchWideNodes<4>(rng, rays, "scalar (no simd)");
+#endif
+#if defined(__AVX__)
+    benchWideNodes<8>(rng, rays, "avx");
+#else
+    benchWideNodes<8>(rng, rays, "sse x2");
+#endif
+
+    // Primitives, opaque triangles skip their back faces before the full test
+    auto opaque = std::make_shared<Material>(Color(.8f), Color(), 0.0f, 0.0f, 1.0f);
+    auto glass = std::make_shared<Material>(Color(1), Color(), 0.0f, 0.0f, 1.5f);
+    std::vector<Triangle> opaqueTriangles, glassTriangles;
+    std::vector<Sphere> spheres;
+    for (size_t i = 0; i < INPUTS; ++i) {
+        Vector3 center = randomPoint(rng, 1);
+        Vector3 v0 = center + randomPoint(rng, .5f), v1 = center + randomPoint(rng, .5f), v2 = center + randomPoint(rng, .5f);
+        opaqueTriangles.emplace_back(v0, v1, v2, opaque);
+        glassTriangles.emplace_back(v0, v1, v2, glass);
+        spheres.emplace_back(center, .3f, opaque);
+    }
+    report("Triangle::intersectsRay", "double scalar, opaque", timeKernel(INPUTS, [&](size_t i) {
+        double t = 0;
+        return opaqueTriangles[i].intersectsRay(rays[i], t) ? t : 0.0;
+    }));
+    report("Triangle::intersectsRay", "double scalar, glass", timeKernel(INPUTS, [&](size_t i) {
+        double t = 0;
+        return glassTriangles[i].intersectsRay(rays[i], t) ? t : 0.0;
+    }));
+    report("Sphere::intersectsRay", "double scalar", timeKernel(INPUTS, [&](size_t i) {
+        double t = 0;
+        return spheres[i].intersectsRay(rays[i], t) ? t : 0.0;
+    }));
+
+    // Traversal, camera rays in scanline order against bounce-like rays in every direction
+    SceneSetup setup = makeSyntheticScene(triangles, 0);
+    std::vector<Hittable*> objects;
+    for (auto& hittable : setup.hittables) objects.push_back(hittable.get());
+    std::unique_ptr<BVHNode> root = BVHNode::build(objects);
+    LinearBVH binary(root.get(), objects);
+    root.reset();
+    BVH4 bvh4(binary);
+    BVH8 bvh8(binary);
+
+    Camera camera(setup.cameraFrom, setup.cameraTo, Vector3d(0.0, 1.0, 0.0), setup.fov, 16.0f / 9.0f);
+    std::vector<Ray> coherent, incoherent;
+    for (int y = 0; y < 64; ++y) {
+        for (int x = 0; x < 64; ++x) coherent.push_back(camera.getRay(x / 63.0f, 1 - y / 63.0f));
+    }
+    for (size_t i = 0; i < INPUTS; ++i) {
+        Vector3d origin = Vector3d(0.0, 1.0, 0.0) + randomDirection(rng) * 1.5;
+        incoherent.emplace_back(origin, randomDirection(rng));
+    }
+    std::string mesh = " (" + std::to_string(objects.size()) + " objects)";
+    std::cout << "Traversal" << mesh << "\n";
+    benchTraversal(binary, "binary double", coherent, incoherent);
+    benchTraversal(bvh4, "wide4 float", coherent, incoherent);
+    benchTraversal(bvh8, "wide8 float", coherent, incoherent);
+
+    // Output
+    std::vector<Color> colors;
+    for (size_t i = 0; i < INPUTS; ++i) colors.emplace_back(rng.nextFloat() * 4, rng.nextFloat() * 4, rng.nextFloat() * 4);
+    report("Color::corrected", "float scalar", timeKernel(INPUTS, [&](size_t i) {
+        return (double)colors[i].corrected().r;
+    }));
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#include <psapi.h>
+#endif
+
+#include "Camera.h"
+#include "Constants.h"
+#include "BVHNode.h"
+#include "BVHStats.h"
+#include "LinearBVH.h"
+#include "WideBVH.h"
+#include "EmitterList.h"
+#include "RenderStats.h"
+#include "RenderSettings.h"
+#include "SyntheticScene.h"
+#include "TraceParser.h"
+
+// Renders scenes at a fixed seed and sample count and reports their throughput as JSON, to compare builds
+
+using namespace std::chrono;
+
+struct SceneResult {
+    std::string name;
+    size_t objects = 0;
+    BVHStats bvh;
+    double loadMs = 0;
+    double primarySeconds = 0;
+    RenderCounters primary; // one camera ray per pixel, first hit only
+    double renderSeconds = 0;
+    RenderCounters render;  // full light transport
+    double meanLuminance = 0; // changes when the image does
+    double peakMemoryMB = 0;
+};
+
+// Peak resident memory since the last reset, where the platform tracks it
+static void resetPeakMemory() {
+#if defined(__linux__)
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+static double getPeakMemoryMB() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#elif defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) return std::stod(line.substr(6)) / 1024.0;
+    }
+#endif
+    return 0;
+}
+
+// Threads take rows from a shared counter, every pixel gets the settings' max samples
+static RenderCounters renderFrame(const Camera& camera, const Accelerator& bvh, const EmitterList& emitters, unsigned threads, double& outSeconds, double& outLuminance) {
+    const RenderSettings& settings = camera.settings;
+    std::vector<PixelAccumulator> pixels(settings.width * settings.height);
+    std::atomic<int> nextRow{ 0 };
+    std::mutex totalMutex;
+    RenderCounters total;
+
+    auto render = [&] {
+        RenderStats::counters = {};
+        for (int y = nextRow++; y < settings.height; y = nextRow++) {
+            for (int x = 0; x < settings.width; ++x) {
+                camera.samplePixel(x, y, settings.width, settings.height, bvh, emitters, pixels[y * settings.width + x], settings.maxSamples);
+            }
+        }
+        std::lock_guard<std::mutex> lock(totalMutex);
+        total.add(RenderStats::counters);
+    };
+
+    auto start = steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; ++t) workers.emplace_back(render);
+    render();
+    for (auto& worker : workers) worker.join();
+    outSeconds = duration<double>(steady_clock::now() - start).count();
+
+    double luminance = 0;
+    for (const PixelAccumulator& pixel : pixels) luminance += pixel.resolve().color.luminance();
+    outLuminance = luminance / pixels.size();
+    return total;
+}
+
+static SceneResult benchmarkScene(const std::string& name, SceneSetup setup, const RenderSettings& settings, double loadMs) {
+    SceneResult result;
+    result.name = name;
+    result.loadMs = loadMs;
+    unsigned threads = settings.getThreadCount();
+
+    BVHNode::scene = std::move(setup.hittables);
+    std::vector<Hittable*> rawScene;
+    for (auto& hittable : BVHNode::scene) rawScene.push_back(hittable.get());
+    result.objects = rawScene.size();
+
+    // Built every time, the cache would hide build regressions
+    BVHBuildSettings buildSettings;
+    buildSettings.threads = threads;
+    auto buildStart = steady_clock::now();
+    std::unique_ptr<BVHNode> root = BVHNode::build(rawScene, buildSettings);
+    auto linearBVH = std::make_unique<LinearBVH>(root.get(), rawScene, buildSettings);
+    root.reset();
+    std::unique_ptr<Accelerator> bvh;
+    if (BVH_LAYOUT == BVHLayout::Wide4)
+        bvh = std::make_unique<BVH4>(*linearBVH);
+    else if (BVH_LAYOUT == BVHLayout::Wide8)
+        bvh = std::make_unique<BVH8>(*linearBVH);
+    result.bvh.buildMs = duration_cast<milliseconds>(steady_clock::now() - buildStart).count();
+    linearBVH->getNodeDebugInfo(result.bvh);
+    result.bvh.sahCost = linearBVH->getSAHCost(buildSettings);
+    result.bvh.totalReferences = (int)linearBVH->primitives.size();
+    if (!bvh) bvh = std::move(linearBVH);
+
+    EmitterList emitters(BVHNode::scene, settings.lightSampling);
+    float aspect = (float)settings.width / settings.height;
+
+    // Camera rays alone, then the full render
+    RenderSettings primarySettings = settings;
+    primarySettings.renderType = RenderType::Depth;
+    primarySettings.finish();
+    Camera primaryCamera(setup.cameraFrom, setup.cameraTo, Vector3d(0.0, 1.0, 0.0), setup.fov, aspect, primarySettings);
+    double unused;
+    result.primary = renderFrame(primaryCamera, *bvh, emitters, threads, result.primarySeconds, unused);
+
+    Camera camera(setup.cameraFrom, setup.cameraTo, Vector3d(0.0, 1.0, 0.0), setup.fov, aspect, settings);
+    result.render = renderFrame(camera, *bvh, emitters, threads, result.renderSeconds, result.meanLuminance);
+
+    result.peakMemoryMB = getPeakMemoryMB();
+    bvh.reset();
+    BVHNode::scene.clear();
+    return result;
+}
+
+static std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+static double perRay(uint64_t count, uint64_t rays) {
+    return rays > 0 ? (double)count / rays : 0;
+}
+
+static std::string toJson(const std::vector<SceneResult>& results, const RenderSettings& settings) {
+    std::ostringstream json;
+    json.precision(6);
+    json << "{\n"
+        << "  \"version\": \"" << VERSION << "\",\n"
+        << "  \"threads\": " << settings.getThreadCount() << ",\n"
+        << "  \"layout\": \"" << BVHLayoutMap.at(BVH_LAYOUT) << "\",\n"
+        << "  \"buildMethod\": \"" << BVHBuildMethodMap.at(BVH_BUILD_METHOD) << "\",\n"
+        << "  \"width\": " << settings.width << ",\n"
+        << "  \"height\": " << settings.height << ",\n"
+        << "  \"samples\": " << settings.maxSamples << ",\n"
+        << "  \"depth\": [" << settings.minDepth << ", " << settings.maxDepth << "],\n"
+        << "  \"seed\": " << settings.seed << ",\n"
+        << "  \"scenes\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const SceneResult& r = results[i];
+        json << "    {\n"
+            << "      \"name\": \"" << escapeJson(r.name) << "\",\n"
+            << "      \"objects\": " << r.objects << ",\n"
+            << "      \"primitiveReferences\": " << r.bvh.totalReferences << ",\n"
+            << "      \"bvhNodes\": " << r.bvh.totalNodes << ",\n"
+            << "      \"sahCost\": " << r.bvh.sahCost << ",\n"
+            << "      \"loadMs\": " << r.loadMs << ",\n"
+            << "      \"buildMs\": " << r.bvh.buildMs << ",\n"
+            << "      \"primaryRays\": " << r.primary.getPrimaryRays() << ",\n"
+            << "      \"primaryRaysPerSecond\": " << r.primary.getPrimaryRays() / std::max(r.primarySeconds, 1e-9) << ",\n"
+            << "      \"primaryNodeTestsPerRay\": " << perRay(r.primary.nodeTests, r.primary.getTotalRays()) << ",\n"
+            << "      \"primaryPrimitiveTestsPerRay\": " << perRay(r.primary.primitiveTests, r.primary.getTotalRays()) << ",\n"
+            << "      \"renderSeconds\": " << r.renderSeconds << ",\n"
+            << "      \"rays\": " << r.render.getRays() << ",\n"
+            << "      \"shadowRays\": " << r.render.shadowRays << ",\n"
+            << "      \"raysPerSecond\": " << r.render.getTotalRays() / std::max(r.renderSeconds, 1e-9) << ",\n"
+            << "      \"nodeTestsPerRay\": " << perRay(r.render.nodeTests, r.render.getTotalRays()) << ",\n"
+            << "      \"primitiveTestsPerRay\": " << perRay(r.render.primitiveTests, r.render.getTotalRays()) << ",\n"
+            << "      \"meanLuminance\": " << r.meanLuminance << ",\n"
+            << "      \"peakMemoryMB\": " << r.peakMemoryMB << "\n"
+            << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
+
+static const char* USAGE =
+    "Usage: pathtracer_bench [scene.trc]... [--synthetic n,n] [--json file] [--name value]...\n"
+    "  Renders the data/ scenes and synthetic meshes of n triangles, or only the scenes given.\n"
+    "  --synthetic list   triangle counts of the synthetic meshes, 0 for none\n"
+    "  --json file        where the results go, instead of stdout\n"
+    "  Other names are render settings, see pathtracer --help. Defaults are 320 wide at 16 samples.\n";
+
+int main(int argc, char** argv) {
+    RenderSettings settings;
+    settings.set("resolution", "verylow");
+    settings.minSamples = settings.maxSamples = 16;
+    settings.renderType = RenderType::Light;
+
+    std::vector<std::string> scenes;
+    std::vector<int> synthetic = { 100000, 1000000 };
+    std::string jsonPath;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            if (argument == "--help" || argument == "-h") {
+                std::cout << USAGE;
+                return 0;
+            }
+            if (argument.rfind("--", 0) != 0) {
+                scenes.push_back(argument);
+                continue;
+            }
+            if (i + 1 >= argc) throw std::runtime_error("Missing value for " + argument);
+
+            std::string name = argument.substr(2), value = argv[++i];
+            if (name == "json") jsonPath = value;
+            else if (name == "synthetic") {
+                synthetic.clear();
+                std::istringstream list(value);
+                for (std::string count; std::getline(list, count, ',');) {
+                    if (std::stoi(count) > 0) synthetic.push_back(std::stoi(count));
+                }
+            }
+            else settings.set(name, value);
+        }
+        settings.finish();
+    }
+    catch (const std::exception& error) {
+        std::cerr << error.what() << "\n\n" << USAGE;
+        return 1;
+    }
+    if (scenes.empty()) scenes = { "data/Cornell.trc", "data/Glass.trc", "data/TestScene.trc", "data/Plane.trc" };
+    else synthetic.clear();
+
+    // Progress on stderr so stdout stays JSON
+    std::vector<SceneResult> results;
+    for (const std::string& scene : scenes) {
+        std::cerr << "Benchmarking " << scene << "..." << std::endl;
+        resetPeakMemory();
+        auto loadStart = steady_clock::now();
+        SceneSetup setup = TraceParser::readTrcFile(scene);
+        double loadMs = duration<double, std::milli>(steady_clock::now() - loadStart).count();
+        results.push_back(benchmarkScene(scene, std::move(setup), settings, loadMs));
+    }
+    for (int triangles : synthetic) {
+        std::string name = "synthetic" + std::to_string(triangles);
+        std::cerr << "Benchmarking " << name << "..." << std::endl;
+        resetPeakMemory();
+        auto loadStart = steady_clock::now();
+        SceneSetup setup = makeSyntheticScene(triangles, settings.seed);
+        double loadMs = duration<double, std::milli>(steady_clock::now() - loadStart).count();
+        results.push_back(benchmarkScene(name, std::move(setup), settings, loadMs));
+    }
+
+    std::string json = toJson(results, settings);
+    if (jsonPath.empty()) {
+        std::cout << json;
+    }
+    else {
+        std::ofstream file(jsonPath);
+        file << json;
+        if (!file) {
+            std::cerr << "Could not write '" << jsonPath << "'\n";
+            return 1;
+        }
+    }
+    return 0;
+}
\ No newline at end of file
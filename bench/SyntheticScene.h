@@ -0,0 +1,47 @@
+#pragma once
+#include "Camera.h"
+#include "Random.h"
+#include "Sphere.h"
+#include "Triangle.h"
+#include "Utilities.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// Bumpy sphere of about the given triangle count over a floor, lit by one small sphere
+inline SceneSetup makeSyntheticScene(int triangles, uint64_t seed) {
+    SceneSetup setup;
+    auto diffuse = std::make_shared<Material>(Color(.8f), Color(), 0.0f, 0.0f, 1.0f);
+    auto light = std::make_shared<Material>(Color(1), Color(12), 0.0f, 0.0f, 1.0f);
+
+    int rings = std::max(2, (int)std::sqrt(triangles / 4.0));
+    int segments = rings * 2;
+    PCG32 rng(seed);
+    std::vector<Vector3> vertices;
+    for (int r = 0; r <= rings; ++r) {
+        float theta = Utilities::PI * r / rings;
+        for (int s = 0; s < segments; ++s) {
+            float phi = 2 * Utilities::PI * s / segments;
+            float radius = 1 + (rng.nextFloat() - .5f) * .04f;
+            vertices.emplace_back(radius * std::sin(theta) * std::cos(phi), 1 + radius * std::cos(theta), radius * std::sin(theta) * std::sin(phi));
+        }
+    }
+    for (int r = 0; r < rings; ++r) {
+        for (int s = 0; s < segments; ++s) {
+            int a = r * segments + s, b = r * segments + (s + 1) % segments;
+            int c = a + segments, d = b + segments;
+            setup.hittables.push_back(std::make_unique<Triangle>(vertices[a], vertices[c], vertices[b], diffuse));
+            setup.hittables.push_back(std::make_unique<Triangle>(vertices[b], vertices[c], vertices[d], diffuse));
+        }
+    }
+
+    setup.hittables.push_back(std::make_unique<Triangle>(Vector3(-10.0f, 0.0f, -10.0f), Vector3(-10.0f, 0.0f, 10.0f), Vector3(10.0f, 0.0f, 10.0f), diffuse));
+    setup.hittables.push_back(std::make_unique<Triangle>(Vector3(-10.0f, 0.0f, -10.0f), Vector3(10.0f, 0.0f, 10.0f), Vector3(10.0f, 0.0f, -10.0f), diffuse));
+    setup.hittables.push_back(std::make_unique<Sphere>(Vector3(2.0f, 4.0f, 2.0f), .5f, light));
+
+    setup.cameraFrom = Vector3(0.0f, 1.5f, 4.0f);
+    setup.cameraTo = Vector3(0.0f, 1.0f, 0.0f);
+    setup.fov = 50;
+    return setup;
+}
\ No newline at end of file
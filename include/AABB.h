@@ -10,6 +10,10 @@ struct AABB {
 
     bool rayHit(const Ray& ray, double& tHit) const;
     Vector3 center() const;
+    float surfaceArea() const;
+    bool isEmpty() const {
+        return lower.x > upper.x || lower.y > upper.y || lower.z > upper.z;
+    }
     static AABB combine(const AABB& box1, const AABB& box2) {
         Vector3 smallCorner(
             std::min(box1.lower.x, box2.lower.x),
@@ -23,4 +27,18 @@ struct AABB {
         );
         return {smallCorner, bigCorner};
     }
+    // Empty when the boxes don't overlap
+    static AABB intersection(const AABB& box1, const AABB& box2) {
+        Vector3 smallCorner(
+            std::max(box1.lower.x, box2.lower.x),
+            std::max(box1.lower.y, box2.lower.y),
+            std::max(box1.lower.z, box2.lower.z)
+        );
+        Vector3 bigCorner(
+            std::min(box1.upper.x, box2.upper.x),
+            std::min(box1.upper.y, box2.upper.y),
+            std::min(box1.upper.z, box2.upper.z)
+        );
+        return {smallCorner, bigCorner};
+    }
 };
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+#include "Hittable.h"
+#include "Ray.h"
+
+// Ray queries shared by every BVH layout
+class Accelerator {
+    public:
+        // Closest hit nearer than hit.t, filling in the record
+        virtual bool intersect(const Ray& ray, HitRecord& hit, int& checks) const = 0;
+        // Whether anything is hit with tMin < t < tMax, stopping at the first such hit
+        virtual bool occluded(const Ray& ray, double tMin, double tMax, int& checks) const = 0;
+
+        virtual ~Accelerator() = default;
+};
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+#include "BVHNode.h"
+#include "Hittable.h"
+#include "LinearBVH.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Flattened BVHs saved between runs, keyed by everything the build depends on
+namespace BVHCache {
+    constexpr uint32_t VERSION = 1;
+
+    // Builds read object bounds, and SBVH also clips triangles against its nodes, so those, the vertices and the settings decide the tree
+    uint64_t hashScene(const std::vector<Hittable*>& objects, const BVHBuildSettings& settings);
+    std::string getCachePath(uint64_t hash);
+
+    std::unique_ptr<LinearBVH> load(const std::string& path, uint64_t hash, const std::vector<std::unique_ptr<Hittable>>& scene, const BVHBuildSettings& settings = {});
+    bool save(const std::string& path, uint64_t hash, const LinearBVH& bvh, const std::vector<std::unique_ptr<Hittable>>& scene);
+}
\ No newline at end of file
@@ -1,37 +1,57 @@
 #pragma once
 #include "AABB.h"
 #include "Hittable.h"
-#include "BVHStats.h"
+#include "Constants.h"
+#include "Threading.h"
 #include <memory>
 #include <vector>
 
+struct BVHBuildSettings {
+    BVHBuildMethod method = BVH_BUILD_METHOD;
+    int bins = SAH_BINS;
+    float traversalCost = SAH_TRAVERSAL_COST;
+    float intersectionCost = 1.0f;
+    int maxLeafSize = MAX_LEAF_SIZE;
+    int mortonBits = LBVH_MORTON_BITS;
+    float spatialSplitAlpha = SBVH_SPATIAL_SPLIT_ALPHA;
+    float maxDuplication = SBVH_MAX_DUPLICATION;
+    unsigned threads = Threading::getThreadCount();
+};
+
+// Objects falling in one SAH bin
+struct BVHBin {
+    AABB bounds;
+    size_t count = 0;
+
+    void add(const AABB& box, size_t n = 1) {
+        bounds = count == 0 ? box : AABB::combine(bounds, box);
+        count += n;
+    }
+    void add(const BVHBin& other) {
+        if (other.count > 0) add(other.bounds, other.count);
+    }
+};
+
 struct BVHNode {
     static std::vector<std::unique_ptr<Hittable>> scene;
     AABB bounds;
     std::unique_ptr<BVHNode> left;
     std::unique_ptr<BVHNode> right;
-    Hittable* object = nullptr; // For leaf
+    size_t start = 0; // For leaf, range in the ordered objects
+    size_t count = 0;
 
-    BVHNode(vector<Hittable*>& objects, size_t start, size_t end);
+    BVHNode() = default;
+    BVHNode(vector<Hittable*>& objects, size_t start, size_t end, const BVHBuildSettings& settings = {});
+
+    // Builds with the chosen method, reordering objects to match the leaves. SBVH may list an object in several leaves
+    static std::unique_ptr<BVHNode> build(vector<Hittable*>& objects, const BVHBuildSettings& settings = {});
 
     bool isLeaf() const {
         return left == nullptr && right == nullptr;
     }
 
-    AABB getBoundingBox(const vector<Hittable*>& objects, size_t start, size_t end) const;
+    AABB getBoundingBox(const vector<Hittable*>& objects, size_t start, size_t end, unsigned threads = 1) const;
     auto compareAlongLongestAxis(const AABB& bounds) const;
-    static void getNodeDebugInfo(const BVHNode* node, int currentDepth, BVHStats& stats) {
-        if (!node) return;
-
-        stats.totalNodes++;
-        if (currentDepth > stats.maxDepth) stats.maxDepth = currentDepth;
-
-        if (node->isLeaf()) {
-            stats.totalLeafNodes++;
-            return;
-        }
-
-        getNodeDebugInfo(node->left.get(), currentDepth + 1, stats);
-        getNodeDebugInfo(node->right.get(), currentDepth + 1, stats);
-    }
+    size_t splitMedian(vector<Hittable*>& objects, size_t start, size_t end) const;
+    size_t splitSAH(vector<Hittable*>& objects, size_t start, size_t end, const BVHBuildSettings& settings, float& outCost) const;
 };
\ No newline at end of file
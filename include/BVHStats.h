@@ -4,4 +4,9 @@ struct BVHStats {
     int totalNodes = 0;
     int maxDepth = 0;
     int totalLeafNodes = 0;
+    int maxLeafSize = 0;
+    int totalReferences = 0; // leaf entries, above the object count when SBVH splits objects
+    float sahCost = 0; // expected cost per ray, in primitive tests
+    long long buildMs = 0;
+    bool cached = false; // loaded instead of built
 };
\ No newline at end of file
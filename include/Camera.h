@@ -7,19 +7,18 @@
 #include "Hittable.h"
 #include "Constants.h"
 #include "PixelData.h"
-#include "BVHNode.h"
+#include "Accelerator.h"
 #include "Vector3d.h"
-
-struct HitRecord {
-    Hittable* object;
-    float t;
-    Vector3d point;
-    Vector3d normal;
-};
+#include "Mesh.h"
+#include "Sampler.h"
+#include "EmitterList.h"
+#include "RenderSettings.h"
 
 struct SceneSetup {
     std::vector<std::unique_ptr<Hittable>> hittables;
     std::unordered_map<string, std::shared_ptr<Material>> materials;
+    std::unordered_map<string, std::shared_ptr<Mesh>> meshes; // by file, shared by instances
+    std::vector<std::string> files; // every file read, the scene file first
     Vector3 cameraFrom{ 0.0f,1.0f,1.0f };
     Vector3 cameraTo{ 0.0f,0.0f,0.0f };
     int fov = 70;
@@ -33,10 +32,11 @@ class Camera {
         Vector3d viewDirection;
 		float verticalFov;
 		float aspect;
+        RenderSettings settings;
 
         Vector3d horizontal, vertical, lowerLeftCorner;
 
-        Camera(const Vector3d& from, const Vector3d& to, const Vector3d& vup, float verticalFov, float aspect);
+        Camera(const Vector3d& from, const Vector3d& to, const Vector3d& vup, float verticalFov, float aspect, const RenderSettings& settings = {});
 
 		void updateCamera();
         void moveCamera(const Vector3d& move) {
@@ -55,12 +55,27 @@ class Camera {
 
         Color getSkybox(const Ray& ray) const;
         Ray getRay(float u, float v) const;
-        const Hittable* getHitObject(const Ray& ray, const BVHNode* bvhRoot, double& outT, int& outChecks) const;
+        const Hittable* getHitObject(const Ray& ray, const Accelerator& bvh, HitRecord& outHit, int& outChecks) const;
+        bool isOccluded(const Ray& ray, const Accelerator& bvh, double tMin, double tMax, int& outChecks) const;
         Vector3d refract(const Vector3d& v, const Vector3d& n, double eta, bool& tir) const;
         Vector3d reflect(const Vector3d& v, const Vector3d& n) const;
 
-        PixelData traceRay(const Ray& ray, const BVHNode* bvhRoot, int depth = 0) const;
-        PixelData tracePixel(int x, int y, int width, int height, const BVHNode* bvhRoot) const;
+        // Direct light from one emitter, weighted against reaching it by a diffuse bounce
+        template <typename PathSampler>
+        Color sampleEmitter(const Vector3d& point, const Vector3d& normal, const Accelerator& bvh, const EmitterList& emitters, PathSampler& sampler) const;
+
+        // Follows one path, depth and normal are from the first hit. Without light transport only the first hit is found
+        template <bool LightTransport, typename PathSampler>
+        PixelData traceRay(const Ray& ray, const Accelerator& bvh, const EmitterList& emitters, PathSampler& sampler) const;
+        // Adds count samples to the pixel, continuing its sample sequence
+        void samplePixel(int x, int y, int width, int height, const Accelerator& bvh, const EmitterList& emitters, PixelAccumulator& pixel, int count) const;
+        // Samples until the variance is low enough or the max samples are reached
+        void tracePixel(int x, int y, int width, int height, const Accelerator& bvh, const EmitterList& emitters, PixelAccumulator& pixel) const;
 
         vector<unsigned char> getRenderOutput(const vector<PixelData>& pixels, RenderType renderType) const;
+
+    private:
+        // Kernels for each mode and sampler, chosen once per call so their inner loops fold the choice away
+        template <bool LightTransport, typename PathSampler>
+        void addSamples(int x, int y, int width, int height, const Accelerator& bvh, const EmitterList& emitters, PixelAccumulator& pixel, int count) const;
 };
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+#include "PixelData.h"
+#include "RenderSettings.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Progressive render state saved while rendering, so a long render can continue after a crash
+namespace Checkpoint {
+    constexpr uint32_t VERSION = 1;
+
+    struct TileState {
+        int32_t passes = 0;
+        bool finished = false;
+    };
+
+    // Copies one tile's pixels, row by row, and returns its progress
+    using TileReader = std::function<TileState(int tile, std::vector<PixelAccumulator>& outPixels)>;
+
+    // Samples are counter based, so the scene, seed and settings that shape a path decide every sample.
+    // sceneFiles are every file the scene was read from, materials and the camera are only in them
+    uint64_t hashRender(const RenderSettings& settings, uint64_t sceneHash, const std::vector<std::string>& sceneFiles, int tileSize);
+
+    // Tiles are read one at a time, rendering only waits on the tile being copied
+    bool save(const std::string& path, uint64_t hash, int width, int height, int tileSize, const TileReader& readTile);
+    bool load(const std::string& path, uint64_t hash, int width, int height, int tileSize, std::vector<PixelAccumulator>& outPixels, std::vector<TileState>& outTiles);
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <map>
 #include <thread>
 #include <string>
@@ -29,7 +30,49 @@ const std::map<RenderType, std::string> RenderTypeMap = {
     {RenderType::All, "all"},
 };
 
-// Render settings
+enum class BVHBuildMethod {
+    Median, // Sort by centroid and split in half
+    SAH,    // Binned surface area heuristic
+    LBVH,   // Morton code order, fast to build
+    SBVH,   // SAH with spatial splits, objects may be referenced by several leaves
+};
+const std::map<BVHBuildMethod, std::string> BVHBuildMethodMap = {
+    {BVHBuildMethod::Median, "median"},
+    {BVHBuildMethod::SAH, "sah"},
+    {BVHBuildMethod::LBVH, "lbvh"},
+    {BVHBuildMethod::SBVH, "sbvh"},
+};
+
+enum class BVHLayout {
+    Binary, // Two children per node
+    Wide4,  // Four children tested together with SSE
+    Wide8,  // Eight children tested together with AVX
+};
+const std::map<BVHLayout, std::string> BVHLayoutMap = {
+    {BVHLayout::Binary, "binary"},
+    {BVHLayout::Wide4, "wide4"},
+    {BVHLayout::Wide8, "wide8"},
+};
+
+enum class SamplerType {
+    Independent, // Uniform random numbers
+    Sobol,       // Owen scrambled Sobol, converges faster
+};
+const std::map<SamplerType, std::string> SamplerTypeMap = {
+    {SamplerType::Independent, "independent"},
+    {SamplerType::Sobol, "sobol"},
+};
+
+enum class LightSampling {
+    Power, // In proportion to emitted power
+    BVH,   // By estimated contribution at the shaded point
+};
+const std::map<LightSampling, std::string> LightSamplingMap = {
+    {LightSampling::Power, "power"},
+    {LightSampling::BVH, "bvh"},
+};
+
+// Render settings, defaults for RenderSettings which the command line or a config file may change
 const std::string SCENE = "data/TestScene.trc";
 constexpr RenderType RENDER_TYPE = RenderType::All;
 constexpr bool SIMPLE_RENDER = (RENDER_TYPE != RenderType::Light) && (RENDER_TYPE != RenderType::Samples) && (RENDER_TYPE != RenderType::All);
@@ -42,18 +85,50 @@ constexpr unsigned MAX_DEPTH   = SIMPLE_RENDER ? 0 : 6; // max bounced to preven
 constexpr unsigned MIN_SAMPLES = SIMPLE_RENDER ? 1 : 32; // minimum adaptive samples
 constexpr unsigned MAX_SAMPLES = SIMPLE_RENDER ? 1 : 128; // cutoff for adaptive sampling
 constexpr float SAMPLE_THRESHOLD = .001f; // threshold for dynamic sampling
+constexpr uint64_t RENDER_SEED = 0; // same seed renders the same image
+constexpr SamplerType SAMPLER = SamplerType::Sobol;
+constexpr bool NEXT_EVENT_ESTIMATION = !SIMPLE_RENDER; // sample emitters directly at diffuse hits
+constexpr LightSampling LIGHT_SAMPLING = LightSampling::BVH;
+constexpr bool PROGRESSIVE = true; // render the whole frame in passes so snapshots show all of it
+constexpr unsigned SAMPLES_PER_PASS = 4; // samples added to each pixel per pass
+constexpr int TIME_BUDGET = 0; // seconds before progressive rendering stops, 0 for none
+constexpr float NOISE_TARGET = .01f; // relative error at which a progressive pixel stops sampling
 
 // Automatic
 constexpr int IMAGE_HEIGHT = (int)(IMAGE_WIDTH / ASPECT);
 
+// BVH
+constexpr BVHBuildMethod BVH_BUILD_METHOD = BVHBuildMethod::SAH;
+constexpr int SAH_BINS = 16; // split candidates per axis
+constexpr float SAH_TRAVERSAL_COST = 1.0f; // node visit cost relative to one primitive test
+constexpr int MAX_LEAF_SIZE = 4; // most primitives SAH may keep in one leaf
+constexpr int LBVH_MORTON_BITS = 30; // 30 or 63 bit Morton codes
+constexpr float SBVH_SPATIAL_SPLIT_ALPHA = 1e-5f; // child overlap, relative to the root area, before spatial splits are tried
+constexpr float SBVH_MAX_DUPLICATION = 0.3f; // extra references spatial splits may add, relative to the object count
+constexpr size_t PARALLEL_BUILD_THRESHOLD = 4096; // objects below which a subtree builds on one thread
+constexpr float REFIT_REBUILD_THRESHOLD = 1.5f; // rebuild once a refit tree costs this much more than when built
+constexpr bool BVH_CACHE = true; // reuse the BVH of an unchanged scene
+const std::string BVH_CACHE_DIR = "cache/";
+#if defined(__AVX__)
+constexpr BVHLayout BVH_LAYOUT = BVHLayout::Wide8;
+#else
+constexpr BVHLayout BVH_LAYOUT = BVHLayout::Wide4;
+#endif
+
 // Technical
-constexpr unsigned THREADS = 4;
+constexpr unsigned THREADS = 0; // render threads, 0 for every core or PATHTRACER_THREADS when set
+constexpr bool PIN_THREADS = false; // keep each render thread on its own core
+constexpr int COARSE_TILES = 4; // tiles per side of the ranges threads are dealt, split further on demand
+constexpr bool RENDER_STATS = true; // count rays, traversal tests and samples per thread for the metadata
 const std::string VERSION = "2.2.0";
 
 // Post processing
 constexpr float EXPOSURE = 1.0f;
 constexpr bool TONE_MAPPED = true; // apply tone mapping
 const std::string OUTPUT_DIR = "output/"; // output directory
+constexpr int CHECKPOINT_INTERVAL = 600; // seconds between checkpoints, 0 for none
+constexpr bool RESUME_RENDER = true; // continue from a checkpoint of the same render
+const std::string TIMELINE_PATH = ""; // Chrome trace of tile execution per thread, none when empty
 
 // Debug
 constexpr float NEAR_PLANE = 3.0f;
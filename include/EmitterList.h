@@ -0,0 +1,29 @@
+#pragma once
+#include "Hittable.h"
+#include "LightBVH.h"
+#include "Constants.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Emissive objects of the scene, picked for direct lighting at a shaded point
+class EmitterList {
+    public:
+        std::vector<const Hittable*> emitters;
+
+        EmitterList(const std::vector<std::unique_ptr<Hittable>>& scene, LightSampling sampling = LIGHT_SAMPLING);
+
+        bool empty() const {
+            return emitters.empty();
+        }
+
+        // Null if no emitter can light the point
+        const Hittable* sample(float u, const Vector3d& point, const Vector3d& normal, float& outPmf) const;
+        float getPmf(const Hittable* emitter, const Vector3d& point, const Vector3d& normal) const;
+
+    private:
+        LightSampling sampling;
+        std::vector<float> cdf; // by power
+        std::unique_ptr<LightBVH> lightBVH;
+        std::unordered_map<const Hittable*, int> indices;
+};
\ No newline at end of file
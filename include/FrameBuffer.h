@@ -0,0 +1,24 @@
+#pragma once
+#include "PixelData.h"
+#include <cstddef>
+
+// Pixel accumulators for the whole frame, left unconstructed until built. The OS places a page on the NUMA node of the
+// thread that first writes it, so pinned render threads each build the tiles they are dealt first
+class FrameBuffer {
+    public:
+        FrameBuffer(int width, int height);
+        FrameBuffer(const FrameBuffer&) = delete;
+        FrameBuffer& operator=(const FrameBuffer&) = delete;
+        ~FrameBuffer();
+
+        // Constructs pixels [start, end), copied from source when given
+        void construct(size_t start, size_t end, const PixelAccumulator* source = nullptr);
+
+        PixelAccumulator& operator[](size_t index) { return pixels[index]; }
+        const PixelAccumulator& operator[](size_t index) const { return pixels[index]; }
+        size_t size() const { return count; }
+
+    private:
+        PixelAccumulator* pixels = nullptr;
+        size_t count = 0;
+};
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "Color.h"
 #include "AABB.h"
 #include "Vector3d.h"
+#include "Sampler.h"
+#include <cfloat>
 
 struct Material {
     Color albedo;
@@ -18,13 +20,57 @@ struct Material {
     Material(const Color& albedo, const Color& emission, float reflectivity, float roughness, float refractiveIndex) : albedo(albedo), emission(emission), reflectivity(reflectivity), roughness(roughness), refractiveIndex(refractiveIndex) {}
 };
 
+class Hittable;
+
+// Closest hit of a query, t starts at the farthest distance wanted and shrinks with each closer hit
+struct HitRecord {
+    double t = DBL_MAX;
+    const Hittable* object = nullptr; // what the scene holds, its material shades the hit
+    const Hittable* shape = nullptr;  // primitive hit, inside object for instances
+};
+
+// Directions within acos(cosTheta) of axis
+struct DirectionCone {
+    Vector3d axis;
+    double cosTheta;
+};
+
 class Hittable {
     public:
         shared_ptr<Material> material;
 
         virtual bool intersectsRay(const Ray& ray, double& outT) const = 0;
-        virtual Vector3d getNormalAt(const Vector3d& point, const Vector3d& dir) const = 0;
+        // Normal at a hit found by intersect
+        virtual Vector3d getNormalAt(const Vector3d& point, const Vector3d& dir, const HitRecord& hit) const = 0;
         virtual AABB getBoundingBox() const = 0;
 
+        // BVH leaf tests. Shapes override them to save a second virtual call, objects holding others to trace into them
+        // Closest hit nearer than hit.t
+        virtual bool intersect(const Ray& ray, HitRecord& hit, int&) const {
+            double t;
+            if (!intersectsRay(ray, t) || t >= hit.t) return false;
+            hit = { t, this, this };
+            return true;
+        }
+        // Whether anything is hit with tMin < t < tMax
+        virtual bool occludes(const Ray& ray, double tMin, double tMax, int&) const {
+            double t;
+            return intersectsRay(ray, t) && t > tMin && t < tMax;
+        }
+
+        // Bounds of the part inside clip, for splitting an object between BVH nodes
+        virtual AABB getClippedBoundingBox(const AABB& clip) const {
+            return AABB::intersection(getBoundingBox(), clip);
+        }
+
+        // Light sampling, shapes without an area are never sampled as emitters
+        virtual double getArea() const { return 0; }
+        // Picks a point that may be visible from 'from', with its pdf over solid angle. False if none can be
+        virtual bool sampleSurface(const Vector3d&, const Sample2D&, Vector3d&, Vector3d&, double&) const { return false; }
+        // Solid angle pdf of sampleSurface picking point
+        virtual double getSurfacePdf(const Vector3d&, const Vector3d&) const { return 0; }
+        // Surface normals light leaves through, every direction unless overridden
+        virtual DirectionCone getNormalCone() const { return { Vector3d(0.0, 0.0, 1.0), -1.0 }; }
+
         virtual ~Hittable() = default;
 };
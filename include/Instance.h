@@ -0,0 +1,30 @@
+#pragma once
+#include "Vector3.h"
+#include "Vector3d.h"
+#include "Ray.h"
+#include "Hittable.h"
+#include "AABB.h"
+#include "Mesh.h"
+#include <memory>
+
+// Mesh placed with a uniform scale, rotation and offset, traced in the mesh's own space with the instance's material
+struct Instance : public Hittable {
+    std::shared_ptr<const Mesh> mesh;
+    double scale;
+    Vector3d offset;
+    Vector3d axes[3]; // mesh x, y, z axes in world space
+
+    Instance(std::shared_ptr<const Mesh> mesh, float scale, const Vector3& offset, const Vector3& rotationDegrees, shared_ptr<Material> mat);
+
+    Vector3d toLocalPoint(const Vector3d& point) const;
+    Vector3d toLocalDirection(const Vector3d& dir) const;
+    Vector3d toWorldDirection(const Vector3d& dir) const;
+
+    Ray toLocalRay(const Ray& ray) const;
+
+    bool intersectsRay(const Ray& ray, double& outT) const override;
+    Vector3d getNormalAt(const Vector3d& point, const Vector3d& dir, const HitRecord& hit) const override;
+    AABB getBoundingBox() const override;
+    bool intersect(const Ray& ray, HitRecord& hit, int& checks) const override;
+    bool occludes(const Ray& ray, double tMin, double tMax, int& checks) const override;
+};
\ No newline at end of file
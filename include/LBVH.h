@@ -0,0 +1,14 @@
+#pragma once
+#include "BVHNode.h"
+#include "Hittable.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Linear BVH, objects sorted along a Morton curve and split where their codes first differ
+namespace LBVH {
+    uint64_t mortonCode(const Vector3& normalized, int bits);
+    void radixSort(std::vector<uint64_t>& codes, std::vector<uint32_t>& indices, int bits, unsigned threads);
+
+    std::unique_ptr<BVHNode> build(vector<Hittable*>& objects, const BVHBuildSettings& settings);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include "AABB.h"
+#include "Hittable.h"
+#include <cstdint>
+#include <vector>
+
+// Where a group of emitters is, how bright, and which way it faces
+struct LightBounds {
+    AABB bounds;
+    DirectionCone normals = { Vector3d(0.0, 0.0, 1.0), 1.0 };
+    double cosEmission = 0; // spread of emission around each normal, cos(pi/2) for diffuse emitters
+    float power = 0;
+
+    static LightBounds combine(const LightBounds& a, const LightBounds& b);
+    // Estimated contribution at a point on a surface with the given normal, 0 if none is possible
+    float importance(const Vector3d& point, const Vector3d& normal) const;
+};
+
+struct LightBVHNode {
+    LightBounds bounds;
+    int32_t offset; // emitter for leaves, right child for interior nodes
+    bool leaf;
+};
+
+// Light BVH (Conty Estevez and Kulla 2018), picks emitters in proportion to their estimated contribution
+class LightBVH {
+    public:
+        static constexpr int MAX_DEPTH = 64; // path to each leaf is kept as bits
+        static constexpr int BINS = 12;
+
+        std::vector<LightBVHNode> nodes; // depth first, the left child directly follows its parent
+
+        LightBVH(const std::vector<const Hittable*>& emitters, const std::vector<float>& powers);
+
+        // Index of the emitter, or -1 if none can light the point
+        int sample(float u, const Vector3d& point, const Vector3d& normal, float& outPmf) const;
+        float getPmf(int emitter, const Vector3d& point, const Vector3d& normal) const;
+
+    private:
+        std::vector<uint64_t> bitTrails; // per emitter, set bits where the path goes right
+
+        int build(const std::vector<LightBounds>& lights, std::vector<int>& indices, size_t start, size_t end, uint64_t bitTrail, int depth);
+};
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include "AABB.h"
+#include "Accelerator.h"
+#include "BVHNode.h"
+#include "BVHStats.h"
+#include "Hittable.h"
+#include "MappedFile.h"
+#include "Ray.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Depth first node, the left child directly follows its parent
+struct LinearBVHNode {
+    AABB bounds;
+    int32_t offset;  // first primitive for leaves, right child for interior nodes
+    uint16_t count;  // primitives in leaf, 0 for interior nodes
+    uint16_t padding;
+};
+static_assert(sizeof(LinearBVHNode) == 32, "LinearBVHNode should fill half a cache line");
+
+class LinearBVH : public Accelerator {
+    public:
+        static constexpr int STACK_SIZE = 128;
+
+        const LinearBVHNode* nodes = nullptr; // owned or memory mapped
+        size_t nodeCount = 0;
+        std::vector<Hittable*> primitives;
+
+        // Settings give the costs the built tree is measured with, for refitOrRebuild
+        LinearBVH(const BVHNode* root, const std::vector<Hittable*>& objects, const BVHBuildSettings& settings = {});
+        LinearBVH(std::shared_ptr<const MappedFile> mapping, const LinearBVHNode* nodes, size_t nodeCount, std::vector<Hittable*> primitives, const BVHBuildSettings& settings = {});
+        LinearBVH(const LinearBVH&) = delete;
+        LinearBVH& operator=(const LinearBVH&) = delete;
+
+        bool intersect(const Ray& ray, HitRecord& hit, int& checks) const override;
+        bool occluded(const Ray& ray, double tMin, double tMax, int& checks) const override;
+
+        // Recomputes bounds bottom up after primitives moved, keeping the topology
+        void refit();
+        // Refits, or rebuilds when the SAH cost grew past threshold times the cost when built
+        bool refitOrRebuild(const BVHBuildSettings& settings, float threshold = REFIT_REBUILD_THRESHOLD);
+
+        float getSAHCost(const BVHBuildSettings& settings, int node = 0) const;
+        void getNodeDebugInfo(BVHStats& stats, int node = 0, int currentDepth = 1) const;
+
+    private:
+        std::vector<LinearBVHNode> ownedNodes;
+        std::shared_ptr<const MappedFile> mapping;
+        float builtCost = 0; // SAH cost of the tree as built or loaded, before any refit
+
+        void rebuild(const BVHBuildSettings& settings);
+
+        int flatten(const BVHNode* node, const std::vector<Hittable*>& objects, int depth);
+};
\ No newline at end of file
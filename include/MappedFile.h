@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read only view of a whole file, paged in by the OS on first access
+class MappedFile {
+    public:
+        MappedFile(const std::string& filename);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        bool isOpen() const { return data != nullptr; }
+        const unsigned char* getData() const { return data; }
+        size_t getSize() const { return size; }
+
+    private:
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+#if defined(_WIN32)
+        void* file = nullptr;
+        void* mapping = nullptr;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#include "AABB.h"
+#include "BVHNode.h"
+#include "Hittable.h"
+#include "LinearBVH.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Geometry loaded once with its own bottom level BVH, shared by every instance of it
+struct Mesh {
+    std::vector<std::unique_ptr<Hittable>> triangles;
+    std::unique_ptr<LinearBVH> bvh;
+    AABB bounds;
+
+    Mesh(std::vector<std::unique_ptr<Hittable>> triangles, const BVHBuildSettings& settings = {});
+
+    // After the triangles moved, instances only see it once the scene BVH over them is refit too, see refitScene
+    void refit(const BVHBuildSettings& settings = {});
+
+    // Refits every mesh, then the scene BVH whose leaves hold their instances. True if the scene BVH was rebuilt.
+    // Wide layouts are collapsed again from it either way
+    static bool refitScene(const std::unordered_map<std::string, std::shared_ptr<Mesh>>& meshes, LinearBVH& sceneBVH, const BVHBuildSettings& settings = {});
+};
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "Vector3.h"
 #include "Color.h"
 #include "Vector3d.h"
+#include <algorithm>
+#include <cmath>
 
 struct PixelData {
     Color color;
@@ -9,4 +11,45 @@ struct PixelData {
     Vector3d normal;
     int checks;
     int samples;
+};
+
+// Running sums of a pixel's samples, so later passes can keep adding to it
+struct PixelAccumulator {
+    Color colorSum;
+    Color colorSumSq;
+    double depthSum = 0;
+    Vector3d normalSum;
+    long long checksSum = 0;
+    int samples = 0;
+
+    void add(const PixelData& sample) {
+        colorSum += sample.color;
+        colorSumSq += sample.color * sample.color;
+        depthSum += sample.depth;
+        normalSum += sample.normal;
+        checksSum += sample.checks;
+        samples++;
+    }
+
+    // Variance of a single sample
+    Color getVariance() const {
+        Color average = colorSum / samples;
+        return (colorSumSq / samples) - (average * average);
+    }
+
+    // Standard error of the mean luminance, relative to the mean
+    float getRelativeError() const {
+        float mean = (colorSum / samples).luminance();
+        float error = std::sqrt(std::max(getVariance().luminance(), 0.0f) / samples);
+        return error / std::max(mean, .01f);
+    }
+
+    PixelData resolve() const {
+        if (samples == 0) return { Color(), 0, Vector3d(), 0, 0 };
+        Color finalColor = colorSum / samples;
+        float finalDepth = depthSum / samples;
+        Vector3d finalNormal = (normalSum / samples).normalized();
+        int finalChecks = int(checksSum / samples);
+        return { finalColor, finalDepth, finalNormal, finalChecks, samples };
+    }
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+// PCG32 (O'Neill), small per-thread generator in place of a shared engine
+class PCG32 {
+    public:
+        PCG32(uint64_t seed = 0, uint64_t stream = 0) : state(0), increment((stream << 1u) | 1u) {
+            nextUint();
+            state += seed;
+            nextUint();
+        }
+
+        // Independent generator for one sample of one pixel, the same on every run
+        static PCG32 forSample(uint32_t x, uint32_t y, uint32_t sample, uint64_t seed) {
+            uint64_t pixel = ((uint64_t)y << 32) | x;
+            return PCG32(mix(mix(seed ^ pixel) + sample), mix(pixel));
+        }
+
+        uint32_t nextUint() {
+            uint64_t old = state;
+            state = old * 6364136223846793005ull + increment;
+            uint32_t xorShifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+            uint32_t rotation = (uint32_t)(old >> 59u);
+            return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+        }
+
+        // Uniform in [0, 1)
+        float nextFloat() {
+            return (nextUint() >> 8) * 0x1p-24f;
+        }
+
+    private:
+        uint64_t state;
+        uint64_t increment;
+
+        // SplitMix64 finalizer, spreads nearby seeds apart
+        static uint64_t mix(uint64_t v) {
+            v += 0x9e3779b97f4a7c15ull;
+            v = (v ^ (v >> 30)) * 0xbf58476d1ce4e5b9ull;
+            v = (v ^ (v >> 27)) * 0x94d049bb133111ebull;
+            return v ^ (v >> 31);
+        }
+};
\ No newline at end of file
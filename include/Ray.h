@@ -2,11 +2,14 @@
 #include "Vector3.h"
 #include "Vector3d.h"
 
+struct Material;
+
 class Ray {
     public:
         Vector3d origin;
         Vector3d direction;
         Vector3d invDirection;
+        const Material* material = nullptr; // replaces the material of the shapes it hits, set by instances tracing into a shared mesh
     
         Ray();
         Ray(const Vector3d& o, const Vector3d& d);
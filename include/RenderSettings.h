@@ -0,0 +1,58 @@
+#pragma once
+#include "Constants.h"
+#include <cstdint>
+#include <string>
+
+// Settings that may change between renders, defaulting to Constants.h. Read from the command line or a config file
+struct RenderSettings {
+    std::string scene = SCENE;
+    std::string outputDir = OUTPUT_DIR;
+    RenderType renderType = RENDER_TYPE;
+    int width = IMAGE_WIDTH;
+    int height = IMAGE_HEIGHT;
+
+    unsigned minDepth = MIN_DEPTH;
+    unsigned maxDepth = MAX_DEPTH;
+    unsigned minSamples = MIN_SAMPLES;
+    unsigned maxSamples = MAX_SAMPLES;
+    float sampleThreshold = SAMPLE_THRESHOLD;
+    uint64_t seed = RENDER_SEED;
+    SamplerType sampler = SAMPLER;
+    bool nextEventEstimation = NEXT_EVENT_ESTIMATION;
+    LightSampling lightSampling = LIGHT_SAMPLING;
+
+    bool progressive = PROGRESSIVE;
+    unsigned samplesPerPass = SAMPLES_PER_PASS;
+    int timeBudget = TIME_BUDGET;
+    float noiseTarget = NOISE_TARGET;
+
+    unsigned threads = THREADS; // 0 for Threading::getThreadCount
+    bool pinThreads = PIN_THREADS;
+    int checkpointInterval = CHECKPOINT_INTERVAL;
+    bool resume = RESUME_RENDER;
+    std::string timelinePath = TIMELINE_PATH;
+
+    // Only first hit AOVs are needed, so paths stop at the camera ray
+    bool isSimple() const {
+        return renderType != RenderType::Light && renderType != RenderType::Samples && renderType != RenderType::All;
+    }
+    unsigned getThreadCount() const;
+    std::string getCheckpointPath() const {
+        return outputDir + "checkpoint.bin";
+    }
+
+    // Sets one setting by its name, as in "max-samples". Throws runtime_error for unknown names or bad values
+    void set(const std::string& name, const std::string& value);
+    // Lines of "name = value", # starts a comment
+    void readConfigFile(const std::string& path);
+
+    // Matches what the constants derive for a simple render, and the height for a new width. Call after setting
+    void finish();
+
+    // [scene] [--config file] [--name value | --name=value]..., later arguments win
+    static RenderSettings fromArguments(int argc, char** argv);
+    static std::string getUsage();
+
+    private:
+        bool heightSet = false;
+};
\ No newline at end of file
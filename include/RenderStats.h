@@ -0,0 +1,63 @@
+#pragma once
+#include "Constants.h"
+#include <cstdint>
+
+// Work done by one thread. Each thread counts into its own copy, summed once its rendering ends
+struct RenderCounters {
+    static constexpr int DEPTHS = 16; // bounces counted apart, deeper ones share the last
+
+    uint64_t raysByDepth[DEPTHS] = {}; // closest hit rays, primary rays at depth 0
+    uint64_t shadowRays = 0;           // occlusion rays toward emitters
+    uint64_t nodeTests = 0;            // interior nodes visited, in every BVH level
+    uint64_t boxTests = 0;             // child bounds tested, several per node
+    uint64_t primitiveTests = 0;
+    uint64_t rouletteTerminations = 0; // paths ended by Russian roulette before the max depth
+    uint64_t samples = 0;
+    uint64_t tiles = 0;
+    double tileSeconds = 0;
+
+    uint64_t getPrimaryRays() const {
+        return raysByDepth[0];
+    }
+    uint64_t getRays() const {
+        uint64_t rays = 0;
+        for (uint64_t count : raysByDepth) rays += count;
+        return rays;
+    }
+    uint64_t getTotalRays() const {
+        return getRays() + shadowRays;
+    }
+
+    void add(const RenderCounters& other) {
+        for (int i = 0; i < DEPTHS; ++i) raysByDepth[i] += other.raysByDepth[i];
+        shadowRays += other.shadowRays;
+        nodeTests += other.nodeTests;
+        boxTests += other.boxTests;
+        primitiveTests += other.primitiveTests;
+        rouletteTerminations += other.rouletteTerminations;
+        samples += other.samples;
+        tiles += other.tiles;
+        tileSeconds += other.tileSeconds;
+    }
+};
+
+namespace RenderStats {
+    // The calling thread's counters
+    inline thread_local RenderCounters counters;
+
+    // Counts the tests of one traversal locally and adds them to the thread's counters when it ends
+    class TraversalCount {
+        public:
+            int nodes = 0;
+            int boxes = 0;
+            int primitives = 0;
+
+            ~TraversalCount() {
+                if constexpr (RENDER_STATS) {
+                    counters.nodeTests += nodes;
+                    counters.boxTests += boxes;
+                    counters.primitiveTests += primitives;
+                }
+            }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+#include "BVHNode.h"
+#include "Hittable.h"
+#include <memory>
+#include <vector>
+
+// Split BVH, SAH build that may also cut objects at a plane and reference them from both sides
+namespace SBVH {
+    // Part of an object, bounded by the cells it was clipped to
+    struct Reference {
+        Hittable* object;
+        AABB bounds;
+    };
+
+    // Replaces objects with the references of each leaf in order, so entries may repeat
+    std::unique_ptr<BVHNode> build(vector<Hittable*>& objects, const BVHBuildSettings& settings);
+}
\ No newline at end of file
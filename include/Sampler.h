@@ -0,0 +1,50 @@
+#pragma once
+#include "Random.h"
+#include <cstdint>
+
+struct Sample2D {
+    float u;
+    float v;
+};
+
+// Supplies the random numbers of one pixel sample, one dimension per call in a fixed order
+class Sampler {
+    public:
+        virtual ~Sampler() = default;
+
+        // Restarts at the first dimension of the given sample
+        virtual void startSample(uint32_t x, uint32_t y, uint32_t index) = 0;
+        virtual float get1D() = 0;
+        virtual Sample2D get2D() = 0;
+};
+
+// Uniform random numbers, every dimension independent
+class IndependentSampler final : public Sampler {
+    public:
+        IndependentSampler(uint64_t seed = 0) : seed(seed) {}
+
+        void startSample(uint32_t x, uint32_t y, uint32_t index) override;
+        float get1D() override;
+        Sample2D get2D() override;
+
+    private:
+        uint64_t seed;
+        PCG32 rng;
+};
+
+// Owen scrambled Sobol (Burley 2020). Each dimension pair gets its own scramble and sample order,
+// so only the first two Sobol dimensions are needed however deep a path goes
+class SobolSampler final : public Sampler {
+    public:
+        SobolSampler(uint64_t seed = 0) : seed((uint32_t)(seed ^ (seed >> 32))) {}
+
+        void startSample(uint32_t x, uint32_t y, uint32_t index) override;
+        float get1D() override;
+        Sample2D get2D() override;
+
+    private:
+        uint32_t seed;
+        uint32_t pixelSeed = 0;
+        uint32_t reversedIndex = 0;
+        uint32_t dimension = 0;
+};
\ No newline at end of file
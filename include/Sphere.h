@@ -16,8 +16,13 @@ struct Sphere : public Hittable {
     Sphere(const Vector3& center, float r, shared_ptr<Material> mat);
 
     bool intersectsRay(const Ray& ray, double& outT) const override;
-    Vector3d getNormalAt(const Vector3d& point, const Vector3d& dir) const override;
+    Vector3d getNormalAt(const Vector3d& point, const Vector3d& dir, const HitRecord& hit) const override;
     AABB getBoundingBox() const override;
+    bool intersect(const Ray& ray, HitRecord& hit, int& checks) const override;
+    bool occludes(const Ray& ray, double tMin, double tMax, int& checks) const override;
+    double getArea() const override;
+    bool sampleSurface(const Vector3d& from, const Sample2D& sample, Vector3d& outPoint, Vector3d& outNormal, double& outPdf) const override;
+    double getSurfacePdf(const Vector3d& from, const Vector3d& point) const override;
     //std::tuple<float, float> getUV(const Vector3& point) const;
     //Color getUVColor(const Vector3& point) const;
 };
\ No newline at end of file
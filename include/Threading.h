@@ -0,0 +1,9 @@
+#pragma once
+
+namespace Threading {
+    // PATHTRACER_THREADS in the environment, else THREADS, else every core the process may run on
+    unsigned getThreadCount();
+
+    // Keeps the calling thread on one core, spread over the cores the process may use
+    bool pinCurrentThread(unsigned index);
+}
\ No newline at end of file
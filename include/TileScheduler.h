@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Rectangle of grid tiles, [x0, x1) by [y0, y1), in one pass
+struct TileRange {
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    int pass = 0;
+
+    int count() const { return (x1 - x0) * (y1 - y0); }
+};
+
+// Work stealing over a grid of tiles, pass after pass. Each thread is dealt a run of coarse ranges, even by cost, and
+// hands them out tile by tile; idle threads steal from the front of other deques, and a thread whose deque has run
+// dry splits off the rest of its range, so costly regions are shared instead of left to one thread
+class TileScheduler {
+    public:
+        // Asked before each pass after the first is dealt, false deals no more but tiles already handed out still finish
+        using PassCheck = std::function<bool(int pass)>;
+
+        TileScheduler(int tilesX, int tilesY, unsigned threads, int coarseSize);
+
+        // Deals out firstPass, each later pass is dealt once the one before is handed out, so passes overlap.
+        // A tile can come up again before its previous pass finishes, callers wait for it
+        void start(int firstPass, PassCheck morePasses);
+        // Next tile for the thread, false once every pass is handed out or the scheduler is stopped.
+        // A thread given a tile renders it, others may be waiting on it for a later pass
+        bool next(unsigned thread, int& outTile, int& outPass);
+        // Ends rendering early, for cancelling. Tiles already handed out may be left unrendered
+        void stop();
+        // Cost of the tile's latest pass, later passes are dealt so every thread starts with an even share
+        void recordTile(int tile, double seconds);
+        // Ranges dealt to the thread and not taken yet, in the order they were dealt
+        std::vector<TileRange> getDealt(unsigned thread);
+
+        double getTileSeconds(int tile) const { return totalCosts[tile]; }
+        bool isStopped() const { return stopped; }
+        int getPass() const { return pass; }
+        long long getSteals() const { return steals; }
+        long long getSplits() const { return splits; }
+
+    private:
+        struct alignas(64) Worker {
+            std::mutex lock;
+            std::deque<TileRange> ranges;
+            TileRange current; // only touched by its own thread
+            int cursorX = 0, cursorY = 0; // next tile of current, row by row
+        };
+
+        int tilesX, tilesY, coarseSize;
+        unsigned threadCount;
+        std::unique_ptr<Worker[]> workers;
+        PassCheck morePasses;
+        std::unique_ptr<std::atomic<double>[]> lastCosts;
+        std::unique_ptr<std::atomic<double>[]> totalCosts;
+        std::mutex passLock;
+        std::atomic<int> pass{ 0 };
+        std::atomic<int> remaining{ 0 }; // tiles of the current pass not handed out yet
+        std::atomic<bool> dealtAll{ false }; // no passes left to deal
+        std::atomic<bool> stopped{ false };
+        std::atomic<long long> steals{ 0 };
+        std::atomic<long long> splits{ 0 };
+
+        void deal(int dealtPass);
+        bool advance(int handedOutPass);
+        bool take(unsigned thread);
+        void splitCurrent(Worker& worker);
+};
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Tile execution on each thread, saved as a Chrome trace (chrome://tracing or ui.perfetto.dev) to show idle threads and stalls
+class TileTimeline {
+    public:
+        struct Event {
+            const char* name; // "tile", or "wait" for a tile's previous pass
+            int tile;
+            int pass;
+            int samples;
+            double start; // seconds from the timeline's start
+            double end;
+        };
+
+        TileTimeline(unsigned threads, std::chrono::steady_clock::time_point begin);
+
+        // Only the owning thread adds to its events, so no lock is taken
+        void record(unsigned thread, const char* name, int tile, int pass, int samples, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+        bool write(const std::string& path) const;
+
+    private:
+        // A cache line each, so threads recording at once don't share one
+        struct alignas(64) ThreadEvents {
+            std::vector<Event> events;
+        };
+
+        std::chrono::steady_clock::time_point begin;
+        std::unique_ptr<ThreadEvents[]> threads;
+        unsigned threadCount;
+};
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include <iostream>
 #include <Triangle.h>
 #include <Sphere.h>
+#include <Instance.h>
 #include <Utilities.h>
 
 using ssMap = std::unordered_map<std::string, std::string>;
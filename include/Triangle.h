@@ -14,6 +14,13 @@ public:
     Triangle(const Vector3& v0, const Vector3& v1, const Vector3& v2, shared_ptr<Material> mat);
 
     bool intersectsRay(const Ray& ray, double& outT) const override;
-    Vector3d getNormalAt(const Vector3d& point, const Vector3d& dir) const override;
+    Vector3d getNormalAt(const Vector3d& point, const Vector3d& dir, const HitRecord& hit) const override;
     AABB getBoundingBox() const override;
+    bool intersect(const Ray& ray, HitRecord& hit, int& checks) const override;
+    bool occludes(const Ray& ray, double tMin, double tMax, int& checks) const override;
+    AABB getClippedBoundingBox(const AABB& clip) const override;
+    double getArea() const override;
+    bool sampleSurface(const Vector3d& from, const Sample2D& sample, Vector3d& outPoint, Vector3d& outNormal, double& outPdf) const override;
+    double getSurfacePdf(const Vector3d& from, const Vector3d& point) const override;
+    DirectionCone getNormalCone() const override;
 };
\ No newline at end of file
@@ -4,7 +4,13 @@
 #include <vector>
 #include "Triangle.h"
 #include "Constants.h"
+#include "RenderSettings.h"
+#include "Random.h"
+#include "Sampler.h"
+#include "Threading.h"
 #include <unordered_map>
+#include <thread>
+#include <algorithm>
 
 // TODO Get good epsilon value around e-8 is good for glass monkey, but causes ghost images in glass sphere
 // Maybe uses multiplier based on where epsilon is being used
@@ -19,21 +25,40 @@ namespace Utilities {
     inline double clamp(double value, double min, double max) {
         return value < min ? min : (value > max ? max : value);
 	}
-    inline string getMetadata() {
+    inline string getMetadata(const RenderSettings& settings) {
         return
             "[v" + VERSION + "]\n"
             "Settings:\n"
-            "  Width: " + std::to_string(IMAGE_WIDTH) + "\n"
-            "  Height: " + std::to_string(IMAGE_HEIGHT) + "\n"
-            "  Sampling: " + std::to_string(MIN_SAMPLES) + "-" + std::to_string(MAX_SAMPLES) + "\n"
-            "  Depth: " + std::to_string(MIN_DEPTH) + "-" + std::to_string(MAX_DEPTH) + "\n"
-            "  Threshold: " + std::to_string(SAMPLE_THRESHOLD) + "\n";
+            "  Scene: " + settings.scene + "\n"
+            "  Type: " + RenderTypeMap.at(settings.renderType) + "\n"
+            "  Width: " + std::to_string(settings.width) + "\n"
+            "  Height: " + std::to_string(settings.height) + "\n"
+            "  Sampling: " + std::to_string(settings.minSamples) + "-" + std::to_string(settings.maxSamples) + " (" + SamplerTypeMap.at(settings.sampler) + ", seed " + std::to_string(settings.seed) + ")\n"
+            "  Depth: " + std::to_string(settings.minDepth) + "-" + std::to_string(settings.maxDepth) + "\n"
+            "  Threshold: " + std::to_string(settings.sampleThreshold) + "\n"
+            "  Threads: " + std::to_string(settings.getThreadCount()) + (settings.pinThreads ? " (pinned)" : "") + "\n"
+            "  Progressive: " + (settings.progressive ? std::to_string(settings.samplesPerPass) + " samples per pass, noise target " + std::to_string(settings.noiseTarget) : "off") + "\n"
+            "  Time budget: " + (settings.timeBudget > 0 ? std::to_string(settings.timeBudget) + " s" : "none") + "\n";
     }
 
+    // Splits [start, end) into one contiguous chunk per thread and waits for all of them
+    template <typename Func>
+    void parallelFor(size_t start, size_t end, unsigned threads, Func&& func) {
+        size_t chunkSize = (end - start + threads - 1) / std::max(1u, threads);
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads && start + t * chunkSize < end; ++t) {
+            workers.emplace_back(func, t, start + t * chunkSize, std::min(end, start + (t + 1) * chunkSize));
+        }
+        func(0u, start, std::min(end, start + chunkSize));
+
+        for (auto& worker : workers) worker.join();
+    }
+
+    // Unseeded, for scene setup. Rendering draws from its sampler
     float randomFloat();
     Color randomColor();
-    Vector3d randomInUnitSphere();
-    Vector3d randomCosineHemisphere(const Vector3d& normal);
+    Vector3d randomInUnitSphere(Sampler& sampler);
+    Vector3d randomCosineHemisphere(const Vector3d& normal, Sampler& sampler);
 
     std::vector<std::unique_ptr<Hittable>> readObjFile(const std::string& filename, std::shared_ptr<Material> meshMaterial, float scale = 1, Vector3 offset = {});
 }
@@ -0,0 +1,43 @@
+#pragma once
+#include "Accelerator.h"
+#include "LinearBVH.h"
+#include "Hittable.h"
+#include "Ray.h"
+#include <cstdint>
+#include <vector>
+
+// Child bounds stored per axis so one SIMD register holds a bound of every child
+template <int Width>
+struct alignas(32) WideBVHNode {
+    float lowerX[Width], lowerY[Width], lowerZ[Width];
+    float upperX[Width], upperY[Width], upperZ[Width];
+    int32_t child[Width];  // node index, or first primitive for leaves
+    uint16_t count[Width]; // primitives in leaf children, 0 for nodes
+    uint8_t childCount;    // used slots, always at the front
+};
+
+template <int Width>
+class WideBVH : public Accelerator {
+    public:
+        static constexpr int STACK_SIZE = LinearBVH::STACK_SIZE * (Width - 1) + 1;
+
+        std::vector<WideBVHNode<Width>> nodes;
+        std::vector<Hittable*> primitives;
+
+        // Collapsed from the binary tree, sharing its primitive order. Collapse again after a refit
+        WideBVH(const LinearBVH& bvh);
+
+        bool intersect(const Ray& ray, HitRecord& hit, int& checks) const override;
+        bool occluded(const Ray& ray, double tMin, double tMax, int& checks) const override;
+
+        // Slab test of every child against one ray, a bit per child hit, with SSE or AVX where compiled in
+        static int intersectChildren(const WideBVHNode<Width>& node, const float origin[3], const float invDir[3], float tMax, float* outNear);
+        // One child at a time, the reference for the SIMD version
+        static int intersectChildrenScalar(const WideBVHNode<Width>& node, const float origin[3], const float invDir[3], float tMax, float* outNear);
+
+    private:
+        int collapse(const LinearBVH& bvh, int binaryNode);
+};
+
+using BVH4 = WideBVH<4>;
+using BVH8 = WideBVH<8>;
\ No newline at end of file
@@ -30,4 +30,9 @@ bool AABB::rayHit(const Ray& ray, double& tHit) const {
 
 Vector3 AABB::center() const {
     return (lower + upper) * 0.5f;
+}
+
+float AABB::surfaceArea() const {
+    Vector3 size = upper - lower;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "BVHCache.h"
+#include "MappedFile.h"
+#include "Triangle.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <unordered_map>
+
+namespace BVHCache {
+    struct CacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t nodeSize;
+        uint64_t hash;
+        uint64_t nodeCount;
+        uint64_t primitiveCount;
+        uint64_t padding[3]; // keeps the nodes 32 byte aligned in the file
+    };
+    static_assert(sizeof(CacheHeader) == 64, "CacheHeader should stay 64 bytes");
+
+    static const char MAGIC[8] = { 'P', 'T', 'B', 'V', 'H', 0, 0, 0 };
+
+    // FNV-1a
+    static void hashBytes(uint64_t& hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    uint64_t hashScene(const std::vector<Hittable*>& objects, const BVHBuildSettings& settings) {
+        uint64_t hash = 14695981039346656037ull;
+        hashBytes(hash, &VERSION, sizeof(VERSION));
+
+        int method = (int)settings.method;
+        hashBytes(hash, &method, sizeof(method));
+        hashBytes(hash, &settings.bins, sizeof(settings.bins));
+        hashBytes(hash, &settings.traversalCost, sizeof(settings.traversalCost));
+        hashBytes(hash, &settings.intersectionCost, sizeof(settings.intersectionCost));
+        hashBytes(hash, &settings.maxLeafSize, sizeof(settings.maxLeafSize));
+        hashBytes(hash, &settings.mortonBits, sizeof(settings.mortonBits));
+        hashBytes(hash, &settings.spatialSplitAlpha, sizeof(settings.spatialSplitAlpha));
+        hashBytes(hash, &settings.maxDuplication, sizeof(settings.maxDuplication));
+
+        uint64_t count = objects.size();
+        hashBytes(hash, &count, sizeof(count));
+        for (const Hittable* object : objects) {
+            AABB box = object->getBoundingBox();
+            float values[6] = { box.lower.x, box.lower.y, box.lower.z, box.upper.x, box.upper.y, box.upper.z };
+            hashBytes(hash, values, sizeof(values));
+
+            // Spatial split bounds follow the triangle inside its box
+            const Triangle* triangle = settings.method == BVHBuildMethod::SBVH ? dynamic_cast<const Triangle*>(object) : nullptr;
+            if (triangle) {
+                float vertices[9] = { triangle->v0.x, triangle->v0.y, triangle->v0.z, triangle->v1.x, triangle->v1.y, triangle->v1.z, triangle->v2.x, triangle->v2.y, triangle->v2.z };
+                hashBytes(hash, vertices, sizeof(vertices));
+            }
+        }
+        return hash;
+    }
+
+    std::string getCachePath(uint64_t hash) {
+        std::ostringstream name;
+        name << BVH_CACHE_DIR << std::hex << std::setw(16) << std::setfill('0') << hash << ".bvh";
+        return name.str();
+    }
+
+    std::unique_ptr<LinearBVH> load(const std::string& path, uint64_t hash, const std::vector<std::unique_ptr<Hittable>>& scene, const BVHBuildSettings& settings) {
+        auto mapping = std::make_shared<MappedFile>(path);
+        if (!mapping->isOpen() || mapping->getSize() < sizeof(CacheHeader))
+            return nullptr;
+
+        CacheHeader header;
+        std::memcpy(&header, mapping->getData(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+            || header.nodeSize != sizeof(LinearBVHNode) || header.hash != hash)
+            return nullptr;
+
+        size_t nodeBytes = header.nodeCount * sizeof(LinearBVHNode);
+        size_t indexBytes = header.primitiveCount * sizeof(uint32_t);
+        if (mapping->getSize() != sizeof(CacheHeader) + nodeBytes + indexBytes)
+            return nullptr;
+
+        // Primitives are stored as indices into the scene
+        const unsigned char* indexData = mapping->getData() + sizeof(CacheHeader) + nodeBytes;
+        std::vector<Hittable*> primitives(header.primitiveCount);
+        for (size_t i = 0; i < primitives.size(); ++i) {
+            uint32_t index;
+            std::memcpy(&index, indexData + i * sizeof(uint32_t), sizeof(index));
+            if (index >= scene.size()) return nullptr;
+            primitives[i] = scene[index].get();
+        }
+
+        const LinearBVHNode* nodes = reinterpret_cast<const LinearBVHNode*>(mapping->getData() + sizeof(CacheHeader));
+        return std::make_unique<LinearBVH>(mapping, nodes, (size_t)header.nodeCount, std::move(primitives), settings);
+    }
+
+    bool save(const std::string& path, uint64_t hash, const LinearBVH& bvh, const std::vector<std::unique_ptr<Hittable>>& scene) {
+        std::unordered_map<const Hittable*, uint32_t> sceneIndex;
+        for (size_t i = 0; i < scene.size(); ++i) sceneIndex[scene[i].get()] = (uint32_t)i;
+
+        std::vector<uint32_t> indices(bvh.primitives.size());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            auto found = sceneIndex.find(bvh.primitives[i]);
+            if (found == sceneIndex.end()) return false;
+            indices[i] = found->second;
+        }
+
+        CacheHeader header = {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.nodeSize = sizeof(LinearBVHNode);
+        header.hash = hash;
+        header.nodeCount = bvh.nodeCount;
+        header.primitiveCount = indices.size();
+
+        // Write beside the cache and swap in, so a crash never leaves half a file
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(bvh.nodes), bvh.nodeCount * sizeof(LinearBVHNode));
+            file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+            if (!file) return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        return !error;
+    }
+}
\ No newline at end of file
@@ -1,23 +1,42 @@
 #include "BVHNode.h"
 #include "AABB.h"
+#include "Utilities.h"
+#include "LBVH.h"
+#include "SBVH.h"
 #include <memory>
 #include <algorithm>
+#include <cfloat>
+#include <future>
 
 
 std::vector<std::unique_ptr<Hittable>> BVHNode::scene;
 
-AABB BVHNode::getBoundingBox(const vector<Hittable*>& objects, size_t start, size_t end) const {
+
+AABB BVHNode::getBoundingBox(const vector<Hittable*>& objects, size_t start, size_t end, unsigned threads) const {
     if (start >= end) return {}; // Return empty
 
-    AABB bounds = objects[start]->getBoundingBox(); // Start with first
+    if (threads <= 1) {
+        AABB bounds = objects[start]->getBoundingBox(); // Start with first
+
+        for (size_t i = start + 1; i < end; ++i) {
+            bounds = AABB::combine(bounds, objects[i]->getBoundingBox()); // Expand
+        }
 
-    for (size_t i = start + 1; i < end; ++i) {
-        bounds = AABB::combine(bounds, objects[i]->getBoundingBox()); // Expand
+        return bounds;
     }
 
-    return bounds;
-}
+    // Each thread bounds its own chunk
+    std::vector<BVHBin> chunks(threads);
+    Utilities::parallelFor(start, end, threads, [&](unsigned chunk, size_t chunkStart, size_t chunkEnd) {
+        for (size_t i = chunkStart; i < chunkEnd; ++i) {
+            chunks[chunk].add(objects[i]->getBoundingBox()); // Expand
+        }
+    });
 
+    BVHBin total;
+    for (const BVHBin& chunk : chunks) total.add(chunk);
+    return total.bounds;
+}
 auto BVHNode::compareAlongLongestAxis(const AABB& bounds) const {
     int axis;
     Vector3 size = bounds.upper - bounds.lower;
@@ -35,25 +54,139 @@ auto BVHNode::compareAlongLongestAxis(const AABB& bounds) const {
     };
 }
 
-BVHNode::BVHNode(vector<Hittable*>& objects, size_t start, size_t end) {
+size_t BVHNode::splitMedian(vector<Hittable*>& objects, size_t start, size_t end) const {
+    // Only the middle has to be in place
+    size_t halfway = start + (end - start) / 2;
+    nth_element(objects.begin() + start, objects.begin() + halfway, objects.begin() + end, compareAlongLongestAxis(bounds));
+
+    return halfway;
+}
+
+size_t BVHNode::splitSAH(vector<Hittable*>& objects, size_t start, size_t end, const BVHBuildSettings& settings, float& outCost) const {
+    unsigned threads = end - start >= PARALLEL_BUILD_THRESHOLD ? settings.threads : 1;
+
+    // Bounds of the centroids, which decide the bin of each object
+    std::vector<BVHBin> centroidChunks(threads);
+    Utilities::parallelFor(start, end, threads, [&](unsigned chunk, size_t chunkStart, size_t chunkEnd) {
+        for (size_t i = chunkStart; i < chunkEnd; ++i) {
+            Vector3 c = objects[i]->getBoundingBox().center();
+            centroidChunks[chunk].add(AABB{ c, c });
+        }
+    });
+    BVHBin centroids;
+    for (const BVHBin& chunk : centroidChunks) centroids.add(chunk);
+    AABB centroidBounds = centroids.bounds;
+    Vector3 extent = centroidBounds.upper - centroidBounds.lower;
+
+    const int binCount = settings.bins;
+    auto binIndex = [&](const Vector3& center, int axis) {
+        float scale = binCount / extent[axis];
+        return std::min(binCount - 1, (int)((center[axis] - centroidBounds.lower[axis]) * scale));
+    };
+
+    // Fill bins for every axis, one set per thread
+    std::vector<BVHBin> chunkBins((size_t)threads * 3 * binCount);
+    Utilities::parallelFor(start, end, threads, [&](unsigned chunk, size_t chunkStart, size_t chunkEnd) {
+        BVHBin* bins = &chunkBins[(size_t)chunk * 3 * binCount];
+        for (size_t i = chunkStart; i < chunkEnd; ++i) {
+            AABB box = objects[i]->getBoundingBox();
+            Vector3 center = box.center();
+            for (int axis = 0; axis < 3; ++axis) {
+                if (extent[axis] > 0) bins[axis * binCount + binIndex(center, axis)].add(box);
+            }
+        }
+    });
+    std::vector<BVHBin> bins(3 * binCount);
+    for (unsigned chunk = 0; chunk < threads; ++chunk) {
+        for (int b = 0; b < 3 * binCount; ++b) bins[b].add(chunkBins[(size_t)chunk * 3 * binCount + b]);
+    }
+
+    int bestAxis = -1;
+    int bestSplit = 0;
+    float bestCost = FLT_MAX;
+    std::vector<float> rightArea(binCount);
+    std::vector<size_t> rightCount(binCount);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        if (extent[axis] <= 0) continue;
+        const BVHBin* axisBins = &bins[axis * binCount];
+
+        // Sweep from the right to get the area and count right of each plane
+        BVHBin accum;
+        for (int b = binCount - 1; b > 0; --b) {
+            accum.add(axisBins[b]);
+            rightArea[b] = accum.count == 0 ? 0 : accum.bounds.surfaceArea();
+            rightCount[b] = accum.count;
+        }
+
+        // Sweep from the left and evaluate the plane before each bin
+        accum = BVHBin();
+        for (int b = 0; b < binCount - 1; ++b) {
+            accum.add(axisBins[b]);
+            if (accum.count == 0 || rightCount[b + 1] == 0) continue;
+
+            float cost = accum.bounds.surfaceArea() * accum.count + rightArea[b + 1] * rightCount[b + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b + 1;
+            }
+        }
+    }
+
+    // All centroids in one bin
+    if (bestAxis == -1) return start;
+    outCost = settings.traversalCost + settings.intersectionCost * bestCost / bounds.surfaceArea();
+
+    auto middle = std::partition(objects.begin() + start, objects.begin() + end, [&](const Hittable* object) {
+        return binIndex(object->getBoundingBox().center(), bestAxis) < bestSplit;
+    });
+    return middle - objects.begin();
+}
+
+BVHNode::BVHNode(vector<Hittable*>& objects, size_t start, size_t end, const BVHBuildSettings& settings) {
     size_t count = end - start;
-    bounds = BVHNode::getBoundingBox(objects, start, end);
-
-    if (count == 1) {
-        // Leaf
-        object = move(objects[start]);
-    } else if (count == 2) {
-        // Left/right with one child each
-        left = make_unique<BVHNode>(objects, start, start + 1);
-        right = make_unique<BVHNode>(objects, start + 1, end);
-    } else {
-        // Sort by axis
-        sort(objects.begin() + start, objects.begin() + end, compareAlongLongestAxis(bounds));
+    bounds = BVHNode::getBoundingBox(objects, start, end, count >= PARALLEL_BUILD_THRESHOLD ? settings.threads : 1);
 
-        size_t halfway = start + count / 2;
+    size_t split = start;
+    float splitCost = FLT_MAX;
+    if (count > 1 && settings.method == BVHBuildMethod::SAH)
+        split = splitSAH(objects, start, end, settings, splitCost);
 
-        // Build left/right
-        left = make_unique<BVHNode>(objects, start, halfway);
-        right = make_unique<BVHNode>(objects, halfway, end);
+    // Leaf when splitting would not be cheaper than testing every object
+    float leafCost = settings.intersectionCost * count;
+    if (count <= 1 || (count <= (size_t)settings.maxLeafSize && leafCost <= splitCost)) {
+        this->start = start;
+        this->count = count;
+        return;
+    }
+
+    // Median split when SAH can't separate the centroids
+    if (split == start || split == end)
+        split = splitMedian(objects, start, end);
+
+    // Build left/right, splitting the threads between large subtrees
+    if (settings.threads > 1 && count >= PARALLEL_BUILD_THRESHOLD) {
+        BVHBuildSettings leftSettings = settings;
+        BVHBuildSettings rightSettings = settings;
+        leftSettings.threads = settings.threads / 2;
+        rightSettings.threads = settings.threads - leftSettings.threads;
+
+        auto leftBuild = std::async(std::launch::async, [&]() {
+            return make_unique<BVHNode>(objects, start, split, leftSettings);
+        });
+        right = make_unique<BVHNode>(objects, split, end, rightSettings);
+        left = leftBuild.get();
+    } else {
+        left = make_unique<BVHNode>(objects, start, split, settings);
+        right = make_unique<BVHNode>(objects, split, end, settings);
     }
 }
+
+std::unique_ptr<BVHNode> BVHNode::build(vector<Hittable*>& objects, const BVHBuildSettings& settings) {
+    if (settings.method == BVHBuildMethod::LBVH)
+        return LBVH::build(objects, settings);
+    if (settings.method == BVHBuildMethod::SBVH)
+        return SBVH::build(objects, settings);
+    return make_unique<BVHNode>(objects, 0, objects.size(), settings);
+}
\ No newline at end of file
@@ -8,11 +8,12 @@
 #include "Constants.h"
 #include "PixelData.h"
 #include "Triangle.h"
-#include <BVHNode.h>
+#include "Accelerator.h"
+#include "RenderStats.h"
 #include <algorithm>
 
-Camera::Camera(const Vector3d& from, const Vector3d& to, const Vector3d& vup, float verticalFov, float aspect)
-    : from(from), to(to), vup(vup), verticalFov(verticalFov), aspect(aspect)
+Camera::Camera(const Vector3d& from, const Vector3d& to, const Vector3d& vup, float verticalFov, float aspect, const RenderSettings& settings)
+    : from(from), to(to), vup(vup), verticalFov(verticalFov), aspect(aspect), settings(settings)
 {
     updateCamera();
 }
@@ -64,69 +65,11 @@ inline Vector3d Camera::reflect(const Vector3d& v, const Vector3d& n) const {
 inline float schlickDielectric(float cosine, float idx) {
     float r0 = (1 - idx) / (1 + idx);
     r0 *= r0; // square
-    return r0 + (1 - r0) * std::powf(1 - cosine, 5);
+    return r0 + (1 - r0) * std::pow(1 - cosine, 5.0f);
 }
 
 inline Color schlickGeneric(float cosine, Color F0) {
-    return F0 + (Color(1) - F0) * std::powf(1 - cosine, 5);
-}
-
-const Hittable* traverseBVH(const BVHNode* node, const Ray& ray, double& closestT, int& checks) {
-    double boxT;
-    if (!node || !node->bounds.rayHit(ray, boxT) || boxT > closestT) {
-        return nullptr;
-    }
-
-    if (node->isLeaf()) {
-        double t;
-        if (node->object->intersectsRay(ray, t) && t < closestT) {
-            closestT = t;
-            return node->object;
-        }
-        return nullptr;
-    }
-    checks++;
-
-    double leftBoxT = DBL_MAX, rightBoxT = DBL_MAX;
-    node->left->bounds.rayHit(ray, leftBoxT);
-    node->right->bounds.rayHit(ray, rightBoxT);
-
-    BVHNode* firstNode = node->left.get();
-    BVHNode* secondNode = node->right.get();
-    double firstBoxT = leftBoxT;
-    double secondBoxT = rightBoxT;
-
-    if (rightBoxT < leftBoxT) {
-        std::swap(firstNode, secondNode);
-        std::swap(firstBoxT, secondBoxT);
-    }
-
-    double firstT = closestT;
-    double secondT = closestT;
-    const Hittable* first = traverseBVH(firstNode, ray, firstT, checks);
-    const Hittable* second = nullptr;
-
-    if (secondBoxT < firstT)
-        second = traverseBVH(secondNode, ray, secondT, checks);
-
-    // Compare closer
-    if (first && second) {
-        if (firstT < secondT) {
-            closestT = firstT;
-            return first;
-        } else {
-            closestT = secondT;
-            return second;
-        }
-    } else if (first) { // Only left
-        closestT = firstT;
-        return first;
-    } else if (second) { // Only right
-        closestT = secondT;
-        return second;
-    }
-
-    return nullptr;
+    return F0 + (Color(1) - F0) * std::pow(1 - cosine, 5.0f);
 }
 
 Color colorThroughDielectric(Color glassColor, double distance, float scale = .5f) {
@@ -142,157 +85,233 @@ Color colorThroughDielectric(Color glassColor, double distance, float scale = .5
 	return result;
 }
 
-const Hittable* Camera::getHitObject(const Ray& ray, const BVHNode* bvhRoot, double& outT, int& outChecks) const {
-    double closestT = DBL_MAX;
-    const Hittable* hitObject = traverseBVH(bvhRoot, ray, closestT, outChecks);
-    outT = closestT;
-    return hitObject;
+const Hittable* Camera::getHitObject(const Ray& ray, const Accelerator& bvh, HitRecord& outHit, int& outChecks) const {
+    outHit = HitRecord();
+    return bvh.intersect(ray, outHit, outChecks) ? outHit.object : nullptr;
 }
 
-PixelData Camera::traceRay(const Ray& ray, const BVHNode* bvhRoot, int depth) const {
-    // Get hit object
-    double t;
-    int c = 0;
-    const Hittable* hitObject = Camera::getHitObject(ray, bvhRoot, t, c);
-
-    // Skybox
-    if (!hitObject)
-        return { Camera::getSkybox(ray), FLT_MAX, Vector3d(), c };
+bool Camera::isOccluded(const Ray& ray, const Accelerator& bvh, double tMin, double tMax, int& outChecks) const {
+    return bvh.occluded(ray, tMin, tMax, outChecks);
+}
 
-    // Hit data
-    Vector3d hitPoint = ray.at(t);
-    Vector3d normal = hitObject->getNormalAt(hitPoint, ray.direction);
-    bool exiting = ray.direction.dot(normal) > 0;
-    if (exiting) normal = -normal;
+// Power heuristic, weight of a strategy that picked a direction with pdf against another with otherPdf
+inline double powerHeuristic(double pdf, double otherPdf) {
+    double squared = pdf * pdf;
+    return squared > 0 ? squared / (squared + otherPdf * otherPdf) : 0;
+}
 
-    // Emmission
-    if (hitObject->material->emission.maxComponent() > Utilities::EPSILON) {
-        return { hitObject->material->emission, t, normal, c };
-    }
+template <typename PathSampler>
+Color Camera::sampleEmitter(const Vector3d& point, const Vector3d& normal, const Accelerator& bvh, const EmitterList& emitters, PathSampler& sampler) const {
+    float pmf;
+    const Hittable* emitter = emitters.sample(sampler.get1D(), point, normal, pmf);
+    Sample2D sample = sampler.get2D();
 
-    Color attenuation = Color(1);
+    Vector3d lightPoint, lightNormal;
+    double pdf;
+    if (!emitter || !emitter->sampleSurface(point, sample, lightPoint, lightNormal, pdf)) return Color();
 
-    // Diffuse, reflect, or refract based on material and randomness
-    Ray bounced;
-    // Dialectric
-    if (hitObject->material->isDielectric()) {
-        // Get reflect or refract
-        double etai = exiting ? hitObject->material->refractiveIndex : 1.0;
-        double etat = exiting ? 1.0 : hitObject->material->refractiveIndex;
-        double etaRatio = etai / etat;
+    Vector3d toLight = lightPoint - point;
+    double distance = toLight.length();
+    Vector3d direction = toLight / distance;
+    double cosine = normal.dot(direction);
+    if (cosine <= 0) return Color();
 
-        float cosTheta = std::fminf((-ray.direction).dot(normal), 1.0f); // angle
-        float reflectProbability = schlickDielectric(cosTheta, etaRatio);
+    // Shadow ray, stopping just short of the emitter itself
+    int c = 0;
+    if constexpr (RENDER_STATS) RenderStats::counters.shadowRays++;
+    Ray shadowRay(point + normal * Utilities::EPSILON, direction);
+    if (Camera::isOccluded(shadowRay, bvh, 0, distance * (1 - 1e-4), c)) return Color();
+
+    double lightPdf = pmf * pdf;
+    double bouncePdf = cosine / Utilities::PI;
+    double weight = powerHeuristic(lightPdf, bouncePdf);
+    return emitter->material->emission * (float)(bouncePdf * weight / lightPdf);
+}
 
-        // Reflect
-        if (Utilities::randomFloat() < reflectProbability) {
-            Vector3d reflectedDir = reflect(ray.direction, normal) + Utilities::randomInUnitSphere() * hitObject->material->roughness;
-            bounced = Ray(hitPoint + normal * Utilities::EPSILON, reflectedDir.normalized());
+template <bool LightTransport, typename PathSampler>
+PixelData Camera::traceRay(const Ray& primaryRay, const Accelerator& bvh, const EmitterList& emitters, PathSampler& sampler) const {
+    // First hit AOVs, color is filled in when the path ends. One path is one sample
+    PixelData result = { Color(), FLT_MAX, Vector3d(), 0, 1 };
+    Color throughput = Color(1);
+    Color radiance = Color();
+    Ray ray = primaryRay;
+
+    // Last bounce, to weight emitters it finds against sampling them directly
+    bool diffuseBounce = false;
+    double bouncePdf = 0;
+    Vector3d bouncePoint, bounceNormal;
+
+    for (unsigned depth = 0; ; ++depth) {
+        // Get hit object
+        HitRecord hit;
+        int c = 0;
+        const Hittable* hitObject = Camera::getHitObject(ray, bvh, hit, c);
+        if (depth == 0) result.checks = c;
+        if constexpr (RENDER_STATS) RenderStats::counters.raysByDepth[std::min<unsigned>(depth, RenderCounters::DEPTHS - 1)]++;
+
+        // Skybox
+        if (!hitObject) {
+            if constexpr (LightTransport) radiance += throughput * Camera::getSkybox(ray);
+            break;
         }
-        // Refract
-        else {
-            bool tir;
-            Vector3d refractedDir = refract(ray.direction, normal, etaRatio, tir) + Utilities::randomInUnitSphere() * hitObject->material->roughness;
-            bounced = Ray(hitPoint - normal * 1e-5, refractedDir.normalized());
 
-            // Exiting non-clear dialectric
-            if (exiting) {
-                attenuation *= colorThroughDielectric(hitObject->material->albedo, t);
+        // Hit data
+        double t = hit.t;
+        Vector3d hitPoint = ray.at(t);
+        Vector3d normal = hitObject->getNormalAt(hitPoint, ray.direction, hit);
+        bool exiting = ray.direction.dot(normal) > 0;
+        if (exiting) normal = -normal;
+
+        if (depth == 0) {
+            result.depth = t;
+            result.normal = normal;
+        }
+        if constexpr (!LightTransport) break;
+
+        // Emmission
+        if (hitObject->material->emission.maxComponent() > Utilities::EPSILON) {
+            double weight = 1;
+            if (settings.nextEventEstimation && diffuseBounce) {
+                double lightPdf = emitters.getPmf(hitObject, bouncePoint, bounceNormal) * hitObject->getSurfacePdf(bouncePoint, hitPoint);
+                weight = powerHeuristic(bouncePdf, lightPdf);
             }
+            radiance += throughput * hitObject->material->emission * (float)weight;
+            break;
         }
-    }
-    // Diffuse
-    else if (Utilities::randomFloat() > hitObject->material->reflectivity) {
-        // Diffuse
-        bounced = Ray(hitPoint + normal * Utilities::EPSILON, Utilities::randomCosineHemisphere(normal));
-        attenuation *= hitObject->material->albedo;
-    }
-    // Reflect
-    else {
-        // Reflect
-        Vector3d reflectedDir = reflect(ray.direction, normal) + Utilities::randomInUnitSphere() * hitObject->material->roughness;
-        bounced = Ray(hitPoint + normal * Utilities::EPSILON, reflectedDir.normalized());
+        diffuseBounce = false;
 
-        // Schlick
-        double cosTheta = std::max(0.0, normal.dot(-ray.direction));
-        attenuation *= schlickGeneric(cosTheta, hitObject->material->albedo * .9f);
-    }
+        Color attenuation = Color(1);
 
-    // Russian roulette
-    if (depth > MIN_DEPTH) {
-        // Dielectric
+        // Diffuse, reflect, or refract based on material and randomness
+        Ray bounced;
+        // Dialectric
         if (hitObject->material->isDielectric()) {
-            constexpr float p = 0.95f; // set probability
-            if (depth > MAX_DEPTH || Utilities::randomFloat() > p)  return { Color(), DBL_MAX, Vector3d(), c };
-			attenuation /= p;
+            // Get reflect or refract
+            double etai = exiting ? hitObject->material->refractiveIndex : 1.0;
+            double etat = exiting ? 1.0 : hitObject->material->refractiveIndex;
+            double etaRatio = etai / etat;
+
+            float cosTheta = std::fminf((-ray.direction).dot(normal), 1.0f); // angle
+            float reflectProbability = schlickDielectric(cosTheta, etaRatio);
+
+            // Reflect
+            if (sampler.get1D() < reflectProbability) {
+                Vector3d reflectedDir = reflect(ray.direction, normal) + Utilities::randomInUnitSphere(sampler) * hitObject->material->roughness;
+                bounced = Ray(hitPoint + normal * Utilities::EPSILON, reflectedDir.normalized());
+            }
+            // Refract
+            else {
+                bool tir;
+                Vector3d refractedDir = refract(ray.direction, normal, etaRatio, tir) + Utilities::randomInUnitSphere(sampler) * hitObject->material->roughness;
+                bounced = Ray(hitPoint - normal * 1e-5, refractedDir.normalized());
+
+                // Exiting non-clear dialectric
+                if (exiting) {
+                    attenuation *= colorThroughDielectric(hitObject->material->albedo, t);
+                }
+            }
+        }
+        // Diffuse
+        else if (sampler.get1D() > hitObject->material->reflectivity) {
+            // Direct light
+            if (settings.nextEventEstimation && !emitters.empty()) {
+                radiance += throughput * hitObject->material->albedo * sampleEmitter(hitPoint, normal, bvh, emitters, sampler);
+            }
+
+            // Diffuse
+            bounced = Ray(hitPoint + normal * Utilities::EPSILON, Utilities::randomCosineHemisphere(normal, sampler));
+            attenuation *= hitObject->material->albedo;
+            diffuseBounce = true;
+            bouncePdf = std::max(0.0, normal.dot(bounced.direction)) / Utilities::PI;
+            bouncePoint = hitPoint;
+            bounceNormal = normal;
         }
-        // Diffusive/reflective
+        // Reflect
         else {
-            float p = max(max(attenuation.r, attenuation.g), attenuation.b);
-            p = Utilities::clamp(p, .1f, 1.0f);
-            if (depth > MAX_DEPTH || Utilities::randomFloat() > p) return { Color(), DBL_MAX, Vector3d(), c };
+            // Reflect
+            Vector3d reflectedDir = reflect(ray.direction, normal) + Utilities::randomInUnitSphere(sampler) * hitObject->material->roughness;
+            bounced = Ray(hitPoint + normal * Utilities::EPSILON, reflectedDir.normalized());
+
+            // Schlick
+            double cosTheta = std::max(0.0, normal.dot(-ray.direction));
+            attenuation *= schlickGeneric(cosTheta, hitObject->material->albedo * .9f);
+        }
+
+        // Russian roulette
+        if (depth > settings.minDepth) {
+            // Dielectric at a set probability, diffusive/reflective by what the bounce keeps
+            float p = 0.95f;
+            if (!hitObject->material->isDielectric()) {
+                p = max(max(attenuation.r, attenuation.g), attenuation.b);
+                p = Utilities::clamp(p, .1f, 1.0f);
+            }
+            if (depth > settings.maxDepth) break;
+            if (sampler.get1D() > p) {
+                if constexpr (RENDER_STATS) RenderStats::counters.rouletteTerminations++;
+                break;
+            }
             attenuation /= p;
         }
-    }
 
-    // Trace bounce
-    PixelData recursive = Camera::traceRay(bounced, bvhRoot, depth + 1);
-    Color final = recursive.color * attenuation;
+        // Continue with the bounce
+        throughput *= attenuation;
+        ray = bounced;
+    }
 
-    return { final, t, normal, c};
+    result.color = radiance;
+    return result;
 }
 
-PixelData Camera::tracePixel(int x, int y, int width, int height, const BVHNode* bvhRoot) const {
-    // Setup color
-    Color colorSum = Color();
-    Color colorSumSq = Color();
-    double depthSum = 0;
-    Vector3d normalSum = Vector3d();
-    int checksSum = 0;
+template <bool LightTransport, typename PathSampler>
+void Camera::addSamples(int x, int y, int width, int height, const Accelerator& bvh, const EmitterList& emitters, PixelAccumulator& pixel, int count) const {
+    // Sample indices carry on from earlier passes
+    PathSampler sampler(settings.seed);
+    bool jitter = settings.maxSamples > 1;
+    for (int i = 0; i < count; ++i) {
+        sampler.startSample(x, y, pixel.samples);
 
-    // Adaptively sample
-    int samples = 0;
-    while (samples < MAX_SAMPLES) {
         // Create ray
-        float offsetX = MAX_SAMPLES <= 1 ? 0 : Utilities::randomFloat() - .5f;
-        float offsetY = MAX_SAMPLES <= 1 ? 0 : Utilities::randomFloat() - .5f;
+        Sample2D offset = sampler.get2D();
+        float offsetX = jitter ? offset.u - .5f : 0;
+        float offsetY = jitter ? offset.v - .5f : 0;
         float u = float(x + offsetX) / float(width - 1);
         float v = 1 - float(y + offsetY) / height;
         const Ray ray = Camera::getRay(u, v);
 
         // Add sample to sums
-        PixelData sample = traceRay(ray, bvhRoot);
-        samples++;
+        pixel.add(traceRay<LightTransport>(ray, bvh, emitters, sampler));
+    }
+    if constexpr (RENDER_STATS) RenderStats::counters.samples += count;
+}
 
-        // Sums
-        colorSum += sample.color;
-        colorSumSq += sample.color * sample.color;
-        depthSum += sample.depth;
-        normalSum += sample.normal;
-        checksSum += sample.checks;
+void Camera::samplePixel(int x, int y, int width, int height, const Accelerator& bvh, const EmitterList& emitters, PixelAccumulator& pixel, int count) const {
+    bool sobol = settings.sampler == SamplerType::Sobol;
+    if (settings.isSimple()) {
+        if (sobol) addSamples<false, SobolSampler>(x, y, width, height, bvh, emitters, pixel, count);
+        else addSamples<false, IndependentSampler>(x, y, width, height, bvh, emitters, pixel, count);
+    }
+    else {
+        if (sobol) addSamples<true, SobolSampler>(x, y, width, height, bvh, emitters, pixel, count);
+        else addSamples<true, IndependentSampler>(x, y, width, height, bvh, emitters, pixel, count);
+    }
+}
+
+void Camera::tracePixel(int x, int y, int width, int height, const Accelerator& bvh, const EmitterList& emitters, PixelAccumulator& pixel) const {
+    // Adaptively sample
+    while (pixel.samples < (int)settings.maxSamples) {
+        samplePixel(x, y, width, height, bvh, emitters, pixel, 1);
 
         // Check variance for early exit
-        if (samples >= MIN_SAMPLES) {
-            Color average = colorSum / samples;
-            Color variance = (colorSumSq / samples) - (average * average);
-            if (variance.luminance() < SAMPLE_THRESHOLD) { break; }
-        }
+        if (pixel.samples >= (int)settings.minSamples && pixel.getVariance().luminance() < settings.sampleThreshold) break;
     }
-
-    // Return final color
-    Color finalColor = colorSum / samples;
-    float finalDepth = depthSum / samples;
-    Vector3d finalNormal = (normalSum / samples).normalized();
-    int finalChecks = checksSum / samples;
-    return { finalColor, finalDepth, finalNormal, finalChecks, samples };
 }
 
 vector<unsigned char> Camera::getRenderOutput(const vector<PixelData>& pixels, RenderType renderType) const {
-    vector<unsigned char> colorData(IMAGE_WIDTH * IMAGE_HEIGHT * 4);
+    vector<unsigned char> colorData(settings.width * settings.height * 4);
 
-    for (int y = 0; y < IMAGE_HEIGHT; y++) {
-        for (int x = 0; x < IMAGE_WIDTH; x++) {
-            int i = y * IMAGE_WIDTH + x;
+    for (int y = 0; y < settings.height; y++) {
+        for (int x = 0; x < settings.width; x++) {
+            int i = y * settings.width + x;
             int p = i * 4;
 
             if (renderType == RenderType::Light) {
@@ -316,7 +335,7 @@ vector<unsigned char> Camera::getRenderOutput(const vector<PixelData>& pixels, R
                 colorData[p + 1] = static_cast<int>(checks * 255);
                 colorData[p + 2] = static_cast<int>(checks * 255);
             } else if (renderType == RenderType::Samples) {
-                float samples = (pixels[i].samples - MIN_SAMPLES) / (float)(MAX_SAMPLES);
+                float samples = (pixels[i].samples - (float)settings.minSamples) / settings.maxSamples;
                 colorData[p] = static_cast<int>(samples * 255);
                 colorData[p + 1] = static_cast<int>(samples * 255);
                 colorData[p + 2] = static_cast<int>(samples * 255);
@@ -328,3 +347,9 @@ vector<unsigned char> Camera::getRenderOutput(const vector<PixelData>& pixels, R
 
     return colorData;
 }
+
+
+template PixelData Camera::traceRay<true, SobolSampler>(const Ray&, const Accelerator&, const EmitterList&, SobolSampler&) const;
+template PixelData Camera::traceRay<true, IndependentSampler>(const Ray&, const Accelerator&, const EmitterList&, IndependentSampler&) const;
+template PixelData Camera::traceRay<false, SobolSampler>(const Ray&, const Accelerator&, const EmitterList&, SobolSampler&) const;
+template PixelData Camera::traceRay<false, IndependentSampler>(const Ray&, const Accelerator&, const EmitterList&, IndependentSampler&) const;
\ No newline at end of file
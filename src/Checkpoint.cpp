@@ -0,0 +1,176 @@
+#include "Checkpoint.h"
+#include "Constants.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace Checkpoint {
+    struct CheckpointHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t tileSize;
+        uint64_t hash;
+        uint32_t width;
+        uint32_t height;
+        uint64_t padding[4];
+    };
+    static_assert(sizeof(CheckpointHeader) == 64, "CheckpointHeader should stay 64 bytes");
+
+    // Fixed layout, independent of PixelAccumulator padding
+    struct PixelRecord {
+        float colorSum[3];
+        float colorSumSq[3];
+        double depthSum;
+        double normalSum[3];
+        int64_t checksSum;
+        int32_t samples;
+        int32_t padding;
+    };
+    static_assert(sizeof(PixelRecord) == 72, "PixelRecord should stay 72 bytes");
+
+    struct TileRecord {
+        int32_t passes;
+        uint32_t finished;
+    };
+
+    static const char MAGIC[8] = { 'P', 'T', 'C', 'K', 'P', 'T', 0, 0 };
+
+    // FNV-1a
+    static void hashBytes(uint64_t& hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    uint64_t hashRender(const RenderSettings& settings, uint64_t sceneHash, const std::vector<std::string>& sceneFiles, int tileSize) {
+        uint64_t hash = 14695981039346656037ull;
+        hashBytes(hash, &VERSION, sizeof(VERSION));
+        hashBytes(hash, &sceneHash, sizeof(sceneHash));
+
+        // Sizes keep one file's end from passing for the next one's start
+        for (const std::string& path : sceneFiles) {
+            std::ifstream file(path, std::ios::binary);
+            std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            uint64_t sizes[] = { path.size(), contents.size() };
+            hashBytes(hash, sizes, sizeof(sizes));
+            hashBytes(hash, path.data(), path.size());
+            hashBytes(hash, contents.data(), contents.size());
+        }
+
+        // Pass sizes and stopping rules decide how far each tile's saved passes got
+        int values[] = { settings.width, settings.height, tileSize, (int)settings.minDepth, (int)settings.maxDepth, (int)settings.minSamples, (int)settings.maxSamples,
+            (int)settings.samplesPerPass, (int)settings.sampler, (int)settings.nextEventEstimation, (int)settings.lightSampling, (int)settings.progressive, (int)settings.isSimple() };
+        float thresholds[] = { settings.sampleThreshold, settings.noiseTarget };
+        hashBytes(hash, values, sizeof(values));
+        hashBytes(hash, thresholds, sizeof(thresholds));
+        hashBytes(hash, &settings.seed, sizeof(settings.seed));
+        return hash;
+    }
+
+    static PixelRecord toRecord(const PixelAccumulator& pixel) {
+        return {
+            { pixel.colorSum.r, pixel.colorSum.g, pixel.colorSum.b },
+            { pixel.colorSumSq.r, pixel.colorSumSq.g, pixel.colorSumSq.b },
+            pixel.depthSum,
+            { pixel.normalSum.x, pixel.normalSum.y, pixel.normalSum.z },
+            pixel.checksSum,
+            pixel.samples,
+            0
+        };
+    }
+
+    static PixelAccumulator fromRecord(const PixelRecord& record) {
+        PixelAccumulator pixel;
+        pixel.colorSum = Color(record.colorSum[0], record.colorSum[1], record.colorSum[2]);
+        pixel.colorSumSq = Color(record.colorSumSq[0], record.colorSumSq[1], record.colorSumSq[2]);
+        pixel.depthSum = record.depthSum;
+        pixel.normalSum = Vector3d(record.normalSum[0], record.normalSum[1], record.normalSum[2]);
+        pixel.checksSum = record.checksSum;
+        pixel.samples = record.samples;
+        return pixel;
+    }
+
+    bool save(const std::string& path, uint64_t hash, int width, int height, int tileSize, const TileReader& readTile) {
+        CheckpointHeader header = {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.tileSize = tileSize;
+        header.hash = hash;
+        header.width = width;
+        header.height = height;
+
+        int tilesX = (width + tileSize - 1) / tileSize;
+        int tilesY = (height + tileSize - 1) / tileSize;
+
+        // Write beside the checkpoint and swap in, so a crash never leaves half a file
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            std::vector<PixelAccumulator> pixels;
+            std::vector<PixelRecord> records;
+            for (int tile = 0; tile < tilesX * tilesY; ++tile) {
+                pixels.clear();
+                TileState state = readTile(tile, pixels);
+
+                TileRecord tileRecord = { state.passes, state.finished ? 1u : 0u };
+                records.resize(pixels.size());
+                std::transform(pixels.begin(), pixels.end(), records.begin(), toRecord);
+                file.write(reinterpret_cast<const char*>(&tileRecord), sizeof(tileRecord));
+                file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(PixelRecord));
+            }
+            if (!file) return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        return !error;
+    }
+
+    bool load(const std::string& path, uint64_t hash, int width, int height, int tileSize, std::vector<PixelAccumulator>& outPixels, std::vector<TileState>& outTiles) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+
+        CheckpointHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.hash != hash
+            || header.width != (uint32_t)width || header.height != (uint32_t)height || header.tileSize != (uint32_t)tileSize)
+            return false;
+
+        // Read everything before touching the outputs, a short file leaves them as they were
+        int tilesX = (width + tileSize - 1) / tileSize;
+        int tilesY = (height + tileSize - 1) / tileSize;
+        std::vector<PixelAccumulator> pixels((size_t)width * height);
+        std::vector<TileState> tiles(tilesX * tilesY);
+        std::vector<PixelRecord> records;
+        for (int tile = 0; tile < tilesX * tilesY; ++tile) {
+            int tileX = (tile % tilesX) * tileSize;
+            int tileY = (tile / tilesX) * tileSize;
+            int tileWidth = std::min(tileSize, width - tileX);
+            int tileHeight = std::min(tileSize, height - tileY);
+
+            TileRecord tileRecord;
+            records.resize(tileWidth * tileHeight);
+            file.read(reinterpret_cast<char*>(&tileRecord), sizeof(tileRecord));
+            file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(PixelRecord));
+            if (!file) return false;
+
+            tiles[tile] = { tileRecord.passes, tileRecord.finished != 0 };
+            for (int y = 0; y < tileHeight; ++y) {
+                for (int x = 0; x < tileWidth; ++x) {
+                    pixels[(tileY + y) * width + tileX + x] = fromRecord(records[y * tileWidth + x]);
+                }
+            }
+        }
+
+        outPixels = std::move(pixels);
+        outTiles = std::move(tiles);
+        return true;
+    }
+}
\ No newline at end of file
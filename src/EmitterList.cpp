@@ -0,0 +1,53 @@
+#include "EmitterList.h"
+#include "Utilities.h"
+#include <algorithm>
+
+EmitterList::EmitterList(const std::vector<std::unique_ptr<Hittable>>& scene, LightSampling sampling) : sampling(sampling) {
+    std::vector<float> powers;
+    float totalPower = 0;
+    for (const auto& object : scene) {
+        float power = object->material->emission.luminance() * (float)object->getArea();
+        if (object->material->emission.maxComponent() <= Utilities::EPSILON || power <= 0) continue;
+
+        indices[object.get()] = (int)emitters.size();
+        emitters.push_back(object.get());
+        powers.push_back(power);
+        totalPower += power;
+    }
+
+    if (sampling == LightSampling::BVH) {
+        lightBVH = std::make_unique<LightBVH>(emitters, powers);
+        return;
+    }
+
+    // Running sum of power
+    float sum = 0;
+    for (size_t i = 0; i < emitters.size(); ++i) {
+        sum += powers[i];
+        cdf.push_back(sum / totalPower);
+    }
+    if (!cdf.empty()) cdf.back() = 1.0f;
+}
+
+const Hittable* EmitterList::sample(float u, const Vector3d& point, const Vector3d& normal, float& outPmf) const {
+    if (emitters.empty()) return nullptr;
+
+    if (lightBVH) {
+        int index = lightBVH->sample(u, point, normal, outPmf);
+        return index < 0 ? nullptr : emitters[index];
+    }
+
+    size_t index = std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+    index = std::min(index, emitters.size() - 1);
+    outPmf = index == 0 ? cdf[0] : cdf[index] - cdf[index - 1];
+    return emitters[index];
+}
+
+float EmitterList::getPmf(const Hittable* emitter, const Vector3d& point, const Vector3d& normal) const {
+    auto it = indices.find(emitter);
+    if (it == indices.end()) return 0.0f;
+
+    int index = it->second;
+    if (lightBVH) return lightBVH->getPmf(index, point, normal);
+    return index == 0 ? cdf[0] : cdf[index] - cdf[index - 1];
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "FrameBuffer.h"
+#include <new>
+#include <type_traits>
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+static_assert(std::is_trivially_destructible<PixelAccumulator>::value, "FrameBuffer never runs pixel destructors");
+
+// Pages straight from the OS, the heap may hand back memory another thread already touched
+#if defined(_WIN32)
+FrameBuffer::FrameBuffer(int width, int height) : count((size_t)width * height) {
+    void* memory = VirtualAlloc(nullptr, count * sizeof(PixelAccumulator), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!memory) throw std::bad_alloc();
+    pixels = static_cast<PixelAccumulator*>(memory);
+}
+
+FrameBuffer::~FrameBuffer() {
+    VirtualFree(pixels, 0, MEM_RELEASE);
+}
+#else
+FrameBuffer::FrameBuffer(int width, int height) : count((size_t)width * height) {
+    void* memory = mmap(nullptr, count * sizeof(PixelAccumulator), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) throw std::bad_alloc();
+    pixels = static_cast<PixelAccumulator*>(memory);
+}
+
+FrameBuffer::~FrameBuffer() {
+    munmap(pixels, count * sizeof(PixelAccumulator));
+}
+#endif
+
+void FrameBuffer::construct(size_t start, size_t end, const PixelAccumulator* source) {
+    for (size_t i = start; i < end; ++i) {
+        if (source) new (&pixels[i]) PixelAccumulator(source[i - start]);
+        else new (&pixels[i]) PixelAccumulator();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "Instance.h"
+#include "Utilities.h"
+#include <algorithm>
+#include <cfloat>
+
+Instance::Instance(std::shared_ptr<const Mesh> mesh, float scale, const Vector3& offset, const Vector3& rotationDegrees, shared_ptr<Material> mat)
+    : mesh(std::move(mesh)), scale(scale), offset(offset) {
+    material = mat;
+
+    // Rotate around x, then y, then z
+    double rx = rotationDegrees.x * Utilities::PI / 180.0;
+    double ry = rotationDegrees.y * Utilities::PI / 180.0;
+    double rz = rotationDegrees.z * Utilities::PI / 180.0;
+    double cx = cos(rx), sx = sin(rx);
+    double cy = cos(ry), sy = sin(ry);
+    double cz = cos(rz), sz = sin(rz);
+
+    axes[0] = Vector3d(cz * cy, sz * cy, -sy);
+    axes[1] = Vector3d(cz * sy * sx - sz * cx, sz * sy * sx + cz * cx, cy * sx);
+    axes[2] = Vector3d(cz * sy * cx + sz * sx, sz * sy * cx - cz * sx, cy * cx);
+}
+
+Vector3d Instance::toLocalPoint(const Vector3d& point) const {
+    return toLocalDirection(point - offset) / scale;
+}
+
+Vector3d Instance::toLocalDirection(const Vector3d& dir) const {
+    return Vector3d(axes[0].dot(dir), axes[1].dot(dir), axes[2].dot(dir));
+}
+
+Vector3d Instance::toWorldDirection(const Vector3d& dir) const {
+    return axes[0] * dir.x + axes[1] * dir.y + axes[2] * dir.z;
+}
+
+Ray Instance::toLocalRay(const Ray& ray) const {
+    // Rotation keeps the direction unit length, so local distances are world distances over scale
+    Ray localRay(toLocalPoint(ray.origin), toLocalDirection(ray.direction));
+    localRay.material = material.get();
+    return localRay;
+}
+
+bool Instance::intersectsRay(const Ray& ray, double& outT) const {
+    HitRecord hit;
+    int checks = 0;
+    if (!intersect(ray, hit, checks)) return false;
+
+    outT = hit.t;
+    return true;
+}
+
+bool Instance::intersect(const Ray& ray, HitRecord& hit, int& checks) const {
+    HitRecord local;
+    local.t = hit.t < DBL_MAX ? hit.t / scale : DBL_MAX;
+    if (!mesh->bvh->intersect(toLocalRay(ray), local, checks)) return false;
+
+    hit = { local.t * scale, this, local.shape };
+    return true;
+}
+
+bool Instance::occludes(const Ray& ray, double tMin, double tMax, int& checks) const {
+    return mesh->bvh->occluded(toLocalRay(ray), tMin / scale, tMax < DBL_MAX ? tMax / scale : DBL_MAX, checks);
+}
+
+Vector3d Instance::getNormalAt(const Vector3d& point, const Vector3d& dir, const HitRecord& hit) const {
+    // The shape hit is in the mesh's space
+    return toWorldDirection(hit.shape->getNormalAt(toLocalPoint(point), toLocalDirection(dir), hit)).normalized();
+}
+
+AABB Instance::getBoundingBox() const {
+    // Bound all eight transformed corners
+    const AABB& local = mesh->bounds;
+    AABB bounds;
+    for (int corner = 0; corner < 8; ++corner) {
+        Vector3d localCorner(
+            (corner & 1) ? local.upper.x : local.lower.x,
+            (corner & 2) ? local.upper.y : local.lower.y,
+            (corner & 4) ? local.upper.z : local.lower.z
+        );
+        Vector3 world = toWorldDirection(localCorner * scale) + offset;
+        bounds = corner == 0 ? AABB{ world, world } : AABB::combine(bounds, { world, world });
+    }
+    return bounds;
+}
\ No newline at end of file
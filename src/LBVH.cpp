@@ -0,0 +1,168 @@
+#include "LBVH.h"
+#include "Utilities.h"
+#include <algorithm>
+#include <future>
+
+namespace LBVH {
+    // Spreads the low bits of v so there are two zero bits between each
+    static uint64_t expandBits(uint64_t v, int bitsPerAxis) {
+        uint64_t result = 0;
+        for (int i = 0; i < bitsPerAxis; ++i) {
+            result |= ((v >> i) & 1ull) << (3 * i);
+        }
+        return result;
+    }
+
+    uint64_t mortonCode(const Vector3& normalized, int bits) {
+        int bitsPerAxis = bits / 3;
+        float scale = (float)((1ull << bitsPerAxis) - 1);
+
+        uint64_t x = (uint64_t)Utilities::clamp(normalized.x * scale, 0.0f, scale);
+        uint64_t y = (uint64_t)Utilities::clamp(normalized.y * scale, 0.0f, scale);
+        uint64_t z = (uint64_t)Utilities::clamp(normalized.z * scale, 0.0f, scale);
+        return (expandBits(x, bitsPerAxis) << 2) | (expandBits(y, bitsPerAxis) << 1) | expandBits(z, bitsPerAxis);
+    }
+
+    void radixSort(std::vector<uint64_t>& codes, std::vector<uint32_t>& indices, int bits, unsigned threads) {
+        constexpr int RADIX_BITS = 8;
+        constexpr int BUCKETS = 1 << RADIX_BITS;
+
+        size_t count = codes.size();
+        threads = count >= PARALLEL_BUILD_THRESHOLD ? std::max(1u, threads) : 1;
+        std::vector<uint64_t> codesOut(count);
+        std::vector<uint32_t> indicesOut(count);
+        std::vector<size_t> histograms((size_t)threads * BUCKETS);
+
+        for (int shift = 0; shift < bits; shift += RADIX_BITS) {
+            // Count digits per chunk
+            std::fill(histograms.begin(), histograms.end(), 0);
+            Utilities::parallelFor(0, count, threads, [&](unsigned chunk, size_t start, size_t end) {
+                size_t* histogram = &histograms[(size_t)chunk * BUCKETS];
+                for (size_t i = start; i < end; ++i) {
+                    histogram[(codes[i] >> shift) & (BUCKETS - 1)]++;
+                }
+            });
+
+            // Offsets ordered by digit then chunk, which keeps the sort stable
+            size_t offset = 0;
+            for (int digit = 0; digit < BUCKETS; ++digit) {
+                for (unsigned chunk = 0; chunk < threads; ++chunk) {
+                    size_t& bucket = histograms[(size_t)chunk * BUCKETS + digit];
+                    size_t bucketCount = bucket;
+                    bucket = offset;
+                    offset += bucketCount;
+                }
+            }
+
+            // Scatter
+            Utilities::parallelFor(0, count, threads, [&](unsigned chunk, size_t start, size_t end) {
+                size_t* histogram = &histograms[(size_t)chunk * BUCKETS];
+                for (size_t i = start; i < end; ++i) {
+                    size_t destination = histogram[(codes[i] >> shift) & (BUCKETS - 1)]++;
+                    codesOut[destination] = codes[i];
+                    indicesOut[destination] = indices[i];
+                }
+            });
+
+            codes.swap(codesOut);
+            indices.swap(indicesOut);
+        }
+    }
+
+    static std::unique_ptr<BVHNode> emit(vector<Hittable*>& objects, const std::vector<uint64_t>& codes, size_t start, size_t end, int bit, const BVHBuildSettings& settings) {
+        auto node = make_unique<BVHNode>();
+        size_t count = end - start;
+
+        if (count <= (size_t)settings.maxLeafSize) {
+            node->bounds = node->getBoundingBox(objects, start, end);
+            node->start = start;
+            node->count = count;
+            return node;
+        }
+
+        // Highest bit where the first and last code differ, everything before it is shared
+        while (bit >= 0 && ((codes[start] ^ codes[end - 1]) >> bit & 1ull) == 0)
+            bit--;
+
+        size_t split;
+        if (bit < 0) {
+            // Identical codes
+            split = start + count / 2;
+        } else {
+            // First code with the bit set
+            uint64_t mask = 1ull << bit;
+            split = std::partition_point(codes.begin() + start, codes.begin() + end, [mask](uint64_t code) {
+                return (code & mask) == 0;
+            }) - codes.begin();
+        }
+
+        // Build left/right, splitting the threads between large subtrees
+        if (settings.threads > 1 && count >= PARALLEL_BUILD_THRESHOLD) {
+            BVHBuildSettings leftSettings = settings;
+            BVHBuildSettings rightSettings = settings;
+            leftSettings.threads = settings.threads / 2;
+            rightSettings.threads = settings.threads - leftSettings.threads;
+
+            auto leftBuild = std::async(std::launch::async, [&]() {
+                return emit(objects, codes, start, split, bit - 1, leftSettings);
+            });
+            node->right = emit(objects, codes, split, end, bit - 1, rightSettings);
+            node->left = leftBuild.get();
+        } else {
+            node->left = emit(objects, codes, start, split, bit - 1, settings);
+            node->right = emit(objects, codes, split, end, bit - 1, settings);
+        }
+
+        node->bounds = AABB::combine(node->left->bounds, node->right->bounds);
+        return node;
+    }
+
+    std::unique_ptr<BVHNode> build(vector<Hittable*>& objects, const BVHBuildSettings& settings) {
+        size_t count = objects.size();
+        if (count == 0) return make_unique<BVHNode>();
+        unsigned threads = count >= PARALLEL_BUILD_THRESHOLD ? settings.threads : 1;
+        int bits = settings.mortonBits >= 63 ? 63 : 30;
+
+        // Centroid bounds to normalize the codes against
+        std::vector<Vector3> centers(count);
+        std::vector<AABB> chunkBounds(threads);
+        std::vector<char> chunkUsed(threads, false);
+        Utilities::parallelFor(0, count, threads, [&](unsigned chunk, size_t start, size_t end) {
+            for (size_t i = start; i < end; ++i) {
+                centers[i] = objects[i]->getBoundingBox().center();
+                chunkBounds[chunk] = i == start ? AABB{ centers[i], centers[i] } : AABB::combine(chunkBounds[chunk], { centers[i], centers[i] });
+            }
+            chunkUsed[chunk] = true;
+        });
+        AABB centroidBounds = chunkBounds[0];
+        for (unsigned chunk = 1; chunk < threads; ++chunk) {
+            if (chunkUsed[chunk]) centroidBounds = AABB::combine(centroidBounds, chunkBounds[chunk]);
+        }
+        Vector3 extent = centroidBounds.upper - centroidBounds.lower;
+
+        // Morton codes
+        std::vector<uint64_t> codes(count);
+        std::vector<uint32_t> indices(count);
+        Utilities::parallelFor(0, count, threads, [&](unsigned, size_t start, size_t end) {
+            for (size_t i = start; i < end; ++i) {
+                Vector3 offset = centers[i] - centroidBounds.lower;
+                Vector3 normalized(
+                    extent.x > 0 ? offset.x / extent.x : 0.0f,
+                    extent.y > 0 ? offset.y / extent.y : 0.0f,
+                    extent.z > 0 ? offset.z / extent.z : 0.0f
+                );
+                codes[i] = mortonCode(normalized, bits);
+                indices[i] = (uint32_t)i;
+            }
+        });
+
+        radixSort(codes, indices, bits, threads);
+
+        // Reorder the objects to match their codes
+        std::vector<Hittable*> sorted(count);
+        for (size_t i = 0; i < count; ++i) sorted[i] = objects[indices[i]];
+        objects.swap(sorted);
+
+        return emit(objects, codes, 0, count, bits - 1, settings);
+    }
+}
\ No newline at end of file
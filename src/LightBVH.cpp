@@ -0,0 +1,242 @@
+#include "LightBVH.h"
+#include "Utilities.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+static double safeAcos(double x) {
+    return std::acos(Utilities::clamp(x, -1.0, 1.0));
+}
+static double safeSqrt(double x) {
+    return std::sqrt(std::max(0.0, x));
+}
+
+// cos and sin of max(0, a - b), from the cos and sin of a and b
+static double cosSubClamped(double sinA, double cosA, double sinB, double cosB) {
+    return cosA > cosB ? 1.0 : cosA * cosB + sinA * sinB;
+}
+static double sinSubClamped(double sinA, double cosA, double sinB, double cosB) {
+    return cosA > cosB ? 0.0 : sinA * cosB - cosA * sinB;
+}
+
+// Rodrigues rotation of v around a unit axis
+static Vector3d rotate(const Vector3d& v, const Vector3d& axis, double angle) {
+    double c = std::cos(angle);
+    double s = std::sin(angle);
+    return v * c + axis.cross(v) * s + axis * (axis.dot(v) * (1.0 - c));
+}
+
+// Smallest cone holding both
+static DirectionCone combineCones(const DirectionCone& a, const DirectionCone& b) {
+    const DirectionCone entireSphere = { Vector3d(0.0, 0.0, 1.0), -1.0 };
+
+    double thetaA = safeAcos(a.cosTheta);
+    double thetaB = safeAcos(b.cosTheta);
+    double thetaD = safeAcos(a.axis.dot(b.axis));
+    if (std::min(thetaD + thetaB, (double)Utilities::PI) <= thetaA) return a;
+    if (std::min(thetaD + thetaA, (double)Utilities::PI) <= thetaB) return b;
+
+    double thetaO = (thetaA + thetaD + thetaB) / 2;
+    if (thetaO >= Utilities::PI) return entireSphere;
+
+    Vector3d rotationAxis = a.axis.cross(b.axis);
+    if (rotationAxis.lengthSquared() == 0) return entireSphere;
+    Vector3d axis = rotate(a.axis, rotationAxis.normalized(), thetaO - thetaA);
+    return { axis.normalized(), std::cos(thetaO) };
+}
+
+LightBounds LightBounds::combine(const LightBounds& a, const LightBounds& b) {
+    if (a.power <= 0) return b;
+    if (b.power <= 0) return a;
+
+    LightBounds combined;
+    combined.bounds = AABB::combine(a.bounds, b.bounds);
+    combined.normals = combineCones(a.normals, b.normals);
+    combined.cosEmission = std::min(a.cosEmission, b.cosEmission);
+    combined.power = a.power + b.power;
+    return combined;
+}
+
+float LightBounds::importance(const Vector3d& point, const Vector3d& normal) const {
+    // Distance to the center, kept from vanishing inside the bounds
+    Vector3d center = Vector3d(bounds.center());
+    Vector3d diagonal = Vector3d(bounds.upper - bounds.lower);
+    Vector3d toPoint = point - center;
+    double distanceSquared = std::max(toPoint.lengthSquared(), diagonal.length() / 2);
+    Vector3d direction = toPoint.normalized();
+
+    // Angle between the normals and the point, reduced by the normal cone and the angle the bounds cover
+    double cosW = normals.axis.dot(direction);
+    double sinW = safeSqrt(1 - cosW * cosW);
+    double radiusSquared = diagonal.lengthSquared() / 4;
+    double cosB = toPoint.lengthSquared() > radiusSquared ? safeSqrt(1 - radiusSquared / toPoint.lengthSquared()) : -1.0;
+    double sinB = safeSqrt(1 - cosB * cosB);
+    double sinO = safeSqrt(1 - normals.cosTheta * normals.cosTheta);
+
+    double cosX = cosSubClamped(sinW, cosW, sinO, normals.cosTheta);
+    double sinX = sinSubClamped(sinW, cosW, sinO, normals.cosTheta);
+    double cosTheta = cosSubClamped(sinX, cosX, sinB, cosB);
+    if (cosTheta <= cosEmission) return 0;
+
+    double importance = power * cosTheta / distanceSquared;
+
+    // Angle at the receiving surface
+    double cosI = std::fabs(direction.dot(normal));
+    double sinI = safeSqrt(1 - cosI * cosI);
+    importance *= cosSubClamped(sinI, cosI, sinB, cosB);
+    return (float)std::max(importance, 0.0);
+}
+
+// Surface area orientation heuristic for one side of a split
+static float orientationCost(const LightBounds& light, const AABB& parentBounds, int axis) {
+    double thetaO = safeAcos(light.normals.cosTheta);
+    double thetaE = safeAcos(light.cosEmission);
+    double thetaW = std::min(thetaO + thetaE, (double)Utilities::PI);
+    double sinO = safeSqrt(1 - light.normals.cosTheta * light.normals.cosTheta);
+    double orientation = 2 * Utilities::PI * (1 - light.normals.cosTheta)
+        + Utilities::PI / 2 * (2 * thetaW * sinO - std::cos(thetaO - 2 * thetaW) - 2 * thetaO * sinO + light.normals.cosTheta);
+
+    // Discourage splitting thin axes
+    Vector3 extent = parentBounds.upper - parentBounds.lower;
+    float maxExtent = std::max({ extent.x, extent.y, extent.z });
+    float regularization = extent[axis] > 0 ? maxExtent / extent[axis] : 1.0f;
+    return (float)(light.power * orientation * regularization * light.bounds.surfaceArea());
+}
+
+LightBVH::LightBVH(const std::vector<const Hittable*>& emitters, const std::vector<float>& powers) {
+    if (emitters.empty()) return;
+
+    std::vector<LightBounds> lights(emitters.size());
+    std::vector<int> indices(emitters.size());
+    for (size_t i = 0; i < emitters.size(); ++i) {
+        lights[i].bounds = emitters[i]->getBoundingBox();
+        lights[i].normals = emitters[i]->getNormalCone();
+        lights[i].power = powers[i];
+        indices[i] = (int)i;
+    }
+
+    bitTrails.resize(emitters.size());
+    nodes.reserve(emitters.size() * 2 - 1);
+    build(lights, indices, 0, indices.size(), 0, 0);
+}
+
+int LightBVH::build(const std::vector<LightBounds>& lights, std::vector<int>& indices, size_t start, size_t end, uint64_t bitTrail, int depth) {
+    int index = (int)nodes.size();
+
+    // Leaf
+    if (end - start == 1) {
+        nodes.push_back({ lights[indices[start]], indices[start], true });
+        bitTrails[indices[start]] = bitTrail;
+        return index;
+    }
+
+    AABB bounds = lights[indices[start]].bounds;
+    Vector3 center = bounds.center();
+    AABB centroidBounds = { center, center };
+    for (size_t i = start; i < end; ++i) {
+        bounds = AABB::combine(bounds, lights[indices[i]].bounds);
+        center = lights[indices[i]].bounds.center();
+        centroidBounds = AABB::combine(centroidBounds, { center, center });
+    }
+
+    // Only median splits once nothing deeper than a balanced tree fits in the bit trail
+    bool balance = depth >= MAX_DEPTH - 1 - (int)std::ceil(std::log2((double)(end - start)));
+
+    // Binned split with the lowest orientation cost
+    int bestAxis = -1;
+    int bestBin = 0;
+    float bestCost = FLT_MAX;
+    for (int axis = 0; axis < 3 && !balance; ++axis) {
+        float lower = centroidBounds.lower[axis];
+        float extent = centroidBounds.upper[axis] - lower;
+        if (extent <= 0) continue;
+
+        LightBounds bins[BINS];
+        for (size_t i = start; i < end; ++i) {
+            const LightBounds& light = lights[indices[i]];
+            int bin = std::min((int)(BINS * (light.bounds.center()[axis] - lower) / extent), BINS - 1);
+            bins[bin] = LightBounds::combine(bins[bin], light);
+        }
+
+        for (int split = 1; split < BINS; ++split) {
+            LightBounds left, right;
+            for (int i = 0; i < split; ++i) left = LightBounds::combine(left, bins[i]);
+            for (int i = split; i < BINS; ++i) right = LightBounds::combine(right, bins[i]);
+            if (left.power <= 0 || right.power <= 0) continue;
+
+            float cost = orientationCost(left, bounds, axis) + orientationCost(right, bounds, axis);
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = split;
+            }
+        }
+    }
+
+    size_t middle;
+    if (bestAxis != -1) {
+        float lower = centroidBounds.lower[bestAxis];
+        float extent = centroidBounds.upper[bestAxis] - lower;
+        middle = std::partition(indices.begin() + start, indices.begin() + end, [&](int light) {
+            int bin = std::min((int)(BINS * (lights[light].bounds.center()[bestAxis] - lower) / extent), BINS - 1);
+            return bin < bestBin;
+        }) - indices.begin();
+    } else {
+        // Coincident centers, or too deep to keep the path as bits
+        middle = (start + end) / 2;
+    }
+
+    // Build left/right
+    nodes.emplace_back();
+    build(lights, indices, start, middle, bitTrail, depth + 1);
+    int right = build(lights, indices, middle, end, bitTrail | (1ull << depth), depth + 1);
+    nodes[index] = { LightBounds::combine(nodes[index + 1].bounds, nodes[right].bounds), right, false };
+    return index;
+}
+
+int LightBVH::sample(float u, const Vector3d& point, const Vector3d& normal, float& outPmf) const {
+    if (nodes.empty()) return -1;
+
+    // Descend choosing children by importance, reusing u for each choice
+    int node = 0;
+    outPmf = 1;
+    while (!nodes[node].leaf) {
+        float leftImportance = nodes[node + 1].bounds.importance(point, normal);
+        float rightImportance = nodes[nodes[node].offset].bounds.importance(point, normal);
+        if (leftImportance <= 0 && rightImportance <= 0) return -1;
+
+        float leftProbability = leftImportance / (leftImportance + rightImportance);
+        if (u < leftProbability) {
+            u = std::min(u / leftProbability, 0x1.fffffep-1f);
+            outPmf *= leftProbability;
+            node = node + 1;
+        } else {
+            u = std::min((u - leftProbability) / (1 - leftProbability), 0x1.fffffep-1f);
+            outPmf *= 1 - leftProbability;
+            node = nodes[node].offset;
+        }
+    }
+
+    if (node == 0 && nodes[0].bounds.importance(point, normal) <= 0) return -1;
+    return nodes[node].offset;
+}
+
+float LightBVH::getPmf(int emitter, const Vector3d& point, const Vector3d& normal) const {
+    if (emitter < 0 || emitter >= (int)bitTrails.size()) return 0;
+
+    // Follow the emitter's path, multiplying the chance of each turn
+    uint64_t bitTrail = bitTrails[emitter];
+    int node = 0;
+    float pmf = 1;
+    while (!nodes[node].leaf) {
+        float leftImportance = nodes[node + 1].bounds.importance(point, normal);
+        float rightImportance = nodes[nodes[node].offset].bounds.importance(point, normal);
+        if (leftImportance <= 0 && rightImportance <= 0) return 0;
+
+        bool goRight = bitTrail & 1;
+        pmf *= (goRight ? rightImportance : leftImportance) / (leftImportance + rightImportance);
+        node = goRight ? nodes[node].offset : node + 1;
+        bitTrail >>= 1;
+    }
+    return pmf;
+}
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "LinearBVH.h"
+#include "RenderStats.h"
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+LinearBVH::LinearBVH(const BVHNode* root, const std::vector<Hittable*>& objects, const BVHBuildSettings& settings) {
+    if (root && !objects.empty()) flatten(root, objects, 1);
+    nodes = ownedNodes.data();
+    nodeCount = ownedNodes.size();
+    builtCost = getSAHCost(settings);
+}
+
+LinearBVH::LinearBVH(std::shared_ptr<const MappedFile> mapping, const LinearBVHNode* nodes, size_t nodeCount, std::vector<Hittable*> primitives, const BVHBuildSettings& settings)
+    : nodes(nodes), nodeCount(nodeCount), primitives(std::move(primitives)), mapping(std::move(mapping)) {
+    builtCost = getSAHCost(settings);
+}
+
+int LinearBVH::flatten(const BVHNode* node, const std::vector<Hittable*>& objects, int depth) {
+    if (depth > STACK_SIZE)
+        throw std::runtime_error("BVH is too deep for the traversal stack");
+
+    int index = (int)ownedNodes.size();
+    ownedNodes.push_back({ node->bounds, 0, 0, 0 });
+
+    if (node->isLeaf()) {
+        if (node->count > UINT16_MAX)
+            throw std::runtime_error("BVH leaf holds more primitives than a node can count");
+        ownedNodes[index].offset = (int32_t)primitives.size();
+        ownedNodes[index].count = (uint16_t)node->count;
+        primitives.insert(primitives.end(), objects.begin() + node->start, objects.begin() + node->start + node->count);
+    } else {
+        flatten(node->left.get(), objects, depth + 1);
+        ownedNodes[index].offset = flatten(node->right.get(), objects, depth + 1);
+    }
+    return index;
+}
+
+bool LinearBVH::intersect(const Ray& ray, HitRecord& hit, int& checks) const {
+    struct StackEntry {
+        int node;
+        double boxT;
+    };
+
+    RenderStats::TraversalCount count;
+    count.boxes = 1; // the root
+    double rootT;
+    if (nodeCount == 0 || !nodes[0].bounds.rayHit(ray, rootT) || rootT > hit.t)
+        return false;
+
+    bool found = false;
+    StackEntry stack[STACK_SIZE];
+    int stackSize = 0;
+    int current = 0;
+
+    while (true) {
+        const LinearBVHNode& node = nodes[current];
+
+        if (node.count > 0) {
+            // Leaf
+            count.primitives += node.count;
+            for (int i = node.offset; i < node.offset + node.count; ++i) {
+                found |= primitives[i]->intersect(ray, hit, checks);
+            }
+        } else {
+            checks++;
+            count.nodes++;
+            count.boxes += 2;
+
+            int first = current + 1;
+            int second = node.offset;
+            double firstT, secondT;
+            bool hitFirst = nodes[first].bounds.rayHit(ray, firstT) && firstT <= hit.t;
+            bool hitSecond = nodes[second].bounds.rayHit(ray, secondT) && secondT <= hit.t;
+
+            // Visit the closer child first and save the other for later
+            if (hitFirst && hitSecond) {
+                if (secondT < firstT) {
+                    std::swap(first, second);
+                    std::swap(firstT, secondT);
+                }
+                stack[stackSize++] = { second, secondT };
+                current = first;
+                continue;
+            }
+            if (hitFirst) {
+                current = first;
+                continue;
+            }
+            if (hitSecond) {
+                current = second;
+                continue;
+            }
+        }
+
+        // Pop the next node that could still be closer than the current hit
+        while (stackSize > 0 && stack[stackSize - 1].boxT > hit.t)
+            stackSize--;
+        if (stackSize == 0)
+            break;
+        current = stack[--stackSize].node;
+    }
+
+    return found;
+}
+
+bool LinearBVH::occluded(const Ray& ray, double tMin, double tMax, int& checks) const {
+    RenderStats::TraversalCount count;
+    count.boxes = 1; // the root
+    double rootT;
+    if (nodeCount == 0 || !nodes[0].bounds.rayHit(ray, rootT) || rootT > tMax)
+        return false;
+
+    int stack[STACK_SIZE];
+    int stackSize = 0;
+    int current = 0;
+
+    while (true) {
+        const LinearBVHNode& node = nodes[current];
+
+        if (node.count > 0) {
+            // Leaf, any hit in range ends the search
+            count.primitives += node.count;
+            for (int i = node.offset; i < node.offset + node.count; ++i) {
+                if (primitives[i]->occludes(ray, tMin, tMax, checks))
+                    return true;
+            }
+        } else {
+            checks++;
+            count.nodes++;
+            count.boxes += 2;
+
+            // Order doesn't matter without a closest hit to shrink the range
+            int first = current + 1;
+            int second = node.offset;
+            double firstT, secondT;
+            bool hitFirst = nodes[first].bounds.rayHit(ray, firstT) && firstT <= tMax;
+            bool hitSecond = nodes[second].bounds.rayHit(ray, secondT) && secondT <= tMax;
+
+            if (hitFirst && hitSecond) {
+                stack[stackSize++] = second;
+                current = first;
+                continue;
+            }
+            if (hitFirst || hitSecond) {
+                current = hitFirst ? first : second;
+                continue;
+            }
+        }
+
+        if (stackSize == 0)
+            return false;
+        current = stack[--stackSize];
+    }
+}
+
+void LinearBVH::refit() {
+    // Mapped nodes are read only
+    if (mapping) {
+        ownedNodes.assign(nodes, nodes + nodeCount);
+        nodes = ownedNodes.data();
+        mapping.reset();
+    }
+
+    // Children always come after their parent, so walking backwards sees them first
+    for (size_t i = ownedNodes.size(); i-- > 0;) {
+        LinearBVHNode& node = ownedNodes[i];
+        if (node.count > 0) {
+            node.bounds = primitives[node.offset]->getBoundingBox();
+            for (int p = node.offset + 1; p < node.offset + node.count; ++p) {
+                node.bounds = AABB::combine(node.bounds, primitives[p]->getBoundingBox());
+            }
+        } else {
+            node.bounds = AABB::combine(ownedNodes[i + 1].bounds, ownedNodes[node.offset].bounds);
+        }
+    }
+}
+
+bool LinearBVH::refitOrRebuild(const BVHBuildSettings& settings, float threshold) {
+    refit();
+    if (getSAHCost(settings) <= builtCost * threshold)
+        return false;
+
+    rebuild(settings);
+    return true;
+}
+
+void LinearBVH::rebuild(const BVHBuildSettings& settings) {
+    // Spatial splits list objects more than once
+    std::vector<Hittable*> objects;
+    std::unordered_set<const Hittable*> seen;
+    for (Hittable* object : primitives) {
+        if (seen.insert(object).second) objects.push_back(object);
+    }
+    std::unique_ptr<BVHNode> root = BVHNode::build(objects, settings);
+
+    ownedNodes.clear();
+    primitives.clear();
+    if (!objects.empty()) flatten(root.get(), objects, 1);
+    nodes = ownedNodes.data();
+    nodeCount = ownedNodes.size();
+    builtCost = getSAHCost(settings);
+}
+
+float LinearBVH::getSAHCost(const BVHBuildSettings& settings, int node) const {
+    if (nodeCount == 0) return 0;
+    if (nodes[node].count > 0) return settings.intersectionCost * nodes[node].count;
+
+    // Children weighted by the chance a ray through this node also hits them
+    const LinearBVHNode& left = nodes[node + 1];
+    const LinearBVHNode& right = nodes[nodes[node].offset];
+    float area = nodes[node].bounds.surfaceArea();
+    float leftCost = getSAHCost(settings, node + 1);
+    float rightCost = getSAHCost(settings, nodes[node].offset);
+    if (area <= 0) return settings.traversalCost + leftCost + rightCost;
+
+    return settings.traversalCost
+        + (left.bounds.surfaceArea() * leftCost + right.bounds.surfaceArea() * rightCost) / area;
+}
+
+void LinearBVH::getNodeDebugInfo(BVHStats& stats, int node, int currentDepth) const {
+    if (nodeCount == 0) return;
+
+    stats.totalNodes++;
+    if (currentDepth > stats.maxDepth) stats.maxDepth = currentDepth;
+
+    if (nodes[node].count > 0) {
+        stats.totalLeafNodes++;
+        if (nodes[node].count > stats.maxLeafSize) stats.maxLeafSize = nodes[node].count;
+        return;
+    }
+
+    getNodeDebugInfo(stats, node + 1, currentDepth + 1);
+    getNodeDebugInfo(stats, nodes[node].offset, currentDepth + 1);
+}
\ No newline at end of file
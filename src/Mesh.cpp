@@ -0,0 +1,24 @@
+#include "Mesh.h"
+
+Mesh::Mesh(std::vector<std::unique_ptr<Hittable>> triangles, const BVHBuildSettings& settings) : triangles(std::move(triangles)) {
+    vector<Hittable*> rawTriangles;
+    rawTriangles.reserve(this->triangles.size());
+    for (auto& triangle : this->triangles) {
+        rawTriangles.push_back(triangle.get());
+    }
+
+    unique_ptr<BVHNode> root = BVHNode::build(rawTriangles, settings);
+    bvh = make_unique<LinearBVH>(root.get(), rawTriangles, settings);
+    bounds = root->bounds;
+}
+
+void Mesh::refit(const BVHBuildSettings& settings) {
+    bvh->refitOrRebuild(settings);
+    if (bvh->nodeCount > 0) bounds = bvh->nodes[0].bounds;
+}
+
+bool Mesh::refitScene(const std::unordered_map<std::string, std::shared_ptr<Mesh>>& meshes, LinearBVH& sceneBVH, const BVHBuildSettings& settings) {
+    // Instance bounds come from their mesh's, so those go first
+    for (const auto& [file, mesh] : meshes) mesh->refit(settings);
+    return sceneBVH.refitOrRebuild(settings);
+}
\ No newline at end of file
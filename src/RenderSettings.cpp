@@ -0,0 +1,177 @@
+#include "RenderSettings.h"
+#include "Threading.h"
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+// Looks a name up in one of the enum maps of Constants.h
+template <typename Enum>
+static Enum parseEnum(const std::map<Enum, std::string>& names, const std::string& name, const std::string& value) {
+    for (const auto& [key, text] : names) {
+        if (text == value) return key;
+    }
+    throw std::runtime_error("Unknown " + name + " '" + value + "'");
+}
+
+static bool parseBool(const std::string& name, const std::string& value) {
+    if (value == "1" || value == "true" || value == "on" || value == "yes") return true;
+    if (value == "0" || value == "false" || value == "off" || value == "no") return false;
+    throw std::runtime_error("Expected true or false for " + name + ", got '" + value + "'");
+}
+
+static long long parseInt(const std::string& name, const std::string& value, long long min) {
+    size_t end = 0;
+    long long result = 0;
+    try {
+        result = std::stoll(value, &end);
+    } catch (const std::exception&) {
+        end = 0;
+    }
+    if (end == 0 || end != value.size() || result < min)
+        throw std::runtime_error("Expected a whole number of at least " + std::to_string(min) + " for " + name + ", got '" + value + "'");
+    return result;
+}
+
+static float parseFloat(const std::string& name, const std::string& value) {
+    size_t end = 0;
+    float result = 0;
+    try {
+        result = std::stof(value, &end);
+    } catch (const std::exception&) {
+        end = 0;
+    }
+    if (end == 0 || end != value.size() || result < 0)
+        throw std::runtime_error("Expected a positive number for " + name + ", got '" + value + "'");
+    return result;
+}
+
+static std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string::npos) return "";
+    return text.substr(start, text.find_last_not_of(" \t\r") - start + 1);
+}
+
+unsigned RenderSettings::getThreadCount() const {
+    return threads > 0 ? threads : Threading::getThreadCount();
+}
+
+void RenderSettings::set(const std::string& name, const std::string& value) {
+    if (name == "scene") scene = value;
+    else if (name == "output") outputDir = value.empty() || value.back() == '/' ? value : value + "/";
+    else if (name == "type") renderType = parseEnum(RenderTypeMap, name, value);
+    else if (name == "resolution") {
+        const std::map<Resolution, std::string> resolutions = {
+            {Resolution::VeryLow, "verylow"}, {Resolution::Low, "low"}, {Resolution::Medium, "medium"},
+            {Resolution::High, "high"}, {Resolution::VeryHigh, "veryhigh"}, {Resolution::Ultra, "ultra"},
+        };
+        width = (int)parseEnum(resolutions, name, value);
+    }
+    else if (name == "width") width = (int)parseInt(name, value, 1);
+    else if (name == "height") {
+        height = (int)parseInt(name, value, 1);
+        heightSet = true;
+    }
+    else if (name == "min-depth") minDepth = (unsigned)parseInt(name, value, 0);
+    else if (name == "max-depth") maxDepth = (unsigned)parseInt(name, value, 0);
+    else if (name == "min-samples") minSamples = (unsigned)parseInt(name, value, 1);
+    else if (name == "max-samples") maxSamples = (unsigned)parseInt(name, value, 1);
+    else if (name == "threshold") sampleThreshold = parseFloat(name, value);
+    else if (name == "seed") seed = (uint64_t)parseInt(name, value, 0);
+    else if (name == "sampler") sampler = parseEnum(SamplerTypeMap, name, value);
+    else if (name == "nee") nextEventEstimation = parseBool(name, value);
+    else if (name == "light-sampling") lightSampling = parseEnum(LightSamplingMap, name, value);
+    else if (name == "progressive") progressive = parseBool(name, value);
+    else if (name == "samples-per-pass") samplesPerPass = (unsigned)parseInt(name, value, 1);
+    else if (name == "time-budget") timeBudget = (int)parseInt(name, value, 0);
+    else if (name == "noise-target") noiseTarget = parseFloat(name, value);
+    else if (name == "threads") threads = (unsigned)parseInt(name, value, 0);
+    else if (name == "pin-threads") pinThreads = parseBool(name, value);
+    else if (name == "checkpoint-interval") checkpointInterval = (int)parseInt(name, value, 0);
+    else if (name == "resume") resume = parseBool(name, value);
+    else if (name == "timeline") timelinePath = value;
+    else throw std::runtime_error("Unknown setting '" + name + "'");
+}
+
+void RenderSettings::readConfigFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("Could not open config file '" + path + "'");
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos)
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected name = value");
+        set(trim(line.substr(0, equals)), trim(line.substr(equals + 1)));
+    }
+}
+
+void RenderSettings::finish() {
+    if (!heightSet) height = std::max(1, (int)(width / ASPECT));
+    if (isSimple()) {
+        minDepth = maxDepth = 0;
+        minSamples = maxSamples = 1;
+        nextEventEstimation = false;
+    }
+    minDepth = std::min(minDepth, maxDepth);
+    minSamples = std::min(minSamples, maxSamples);
+}
+
+RenderSettings RenderSettings::fromArguments(int argc, char** argv) {
+    RenderSettings settings;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument.rfind("--", 0) != 0) {
+            settings.scene = argument;
+            continue;
+        }
+
+        // --name=value or --name value
+        std::string name = argument.substr(2), value;
+        size_t equals = name.find('=');
+        if (equals != std::string::npos) {
+            value = name.substr(equals + 1);
+            name = name.substr(0, equals);
+        }
+        else if (i + 1 < argc) {
+            value = argv[++i];
+        }
+        else {
+            throw std::runtime_error("Missing value for --" + name);
+        }
+
+        if (name == "config") settings.readConfigFile(value);
+        else settings.set(name, value);
+    }
+    settings.finish();
+    return settings;
+}
+
+std::string RenderSettings::getUsage() {
+    return
+        "Usage: pathtracer [scene.trc] [--config file] [--name value]...\n"
+        "  --output dir              where renders, snapshots and checkpoints go\n"
+        "  --type name               light, normals, depth, bvh, samples or all\n"
+        "  --resolution name         verylow, low, medium, high, veryhigh or ultra width\n"
+        "  --width n, --height n     height follows the width at 16:9 unless given\n"
+        "  --min-depth n, --max-depth n\n"
+        "  --min-samples n, --max-samples n\n"
+        "  --threshold x             variance at which adaptive sampling stops\n"
+        "  --seed n                  same seed renders the same image\n"
+        "  --sampler name            independent or sobol\n"
+        "  --nee bool                sample emitters directly\n"
+        "  --light-sampling name     power or bvh\n"
+        "  --progressive bool, --samples-per-pass n\n"
+        "  --time-budget s           0 for none\n"
+        "  --noise-target x          relative error at which a pixel stops\n"
+        "  --threads n               0 for every core\n"
+        "  --pin-threads bool\n"
+        "  --checkpoint-interval s   0 for none\n"
+        "  --resume bool\n"
+        "  --timeline file           Chrome trace of the tiles each thread rendered\n"
+        "A config file holds the same names as \"name = value\" lines.\n";
+}
\ No newline at end of file
@@ -0,0 +1,283 @@
+#include "SBVH.h"
+#include "LinearBVH.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace SBVH {
+    struct Split {
+        float cost = FLT_MAX; // unnormalized, area times count summed over both sides
+        int axis = -1;
+        float position = 0;   // spatial splits only
+        int bin = 0;          // object splits only
+        AABB leftBounds;
+        AABB rightBounds;
+    };
+
+    struct Builder {
+        const BVHBuildSettings& settings;
+        std::vector<Hittable*> leaves;
+        float rootArea = 0;
+        size_t referenceLimit = 0;
+        size_t referenceCount = 0; // only counts the duplicates of splits kept
+
+        Builder(const BVHBuildSettings& settings) : settings(settings) {}
+
+        std::unique_ptr<BVHNode> build(std::vector<Reference>& refs, int depth);
+        Split findObjectSplit(const std::vector<Reference>& refs, const AABB& centroidBounds) const;
+        Split findSpatialSplit(const std::vector<Reference>& refs, const AABB& bounds) const;
+        // Returns the references added, which count against the budget once the split is kept
+        size_t splitSpatial(std::vector<Reference>& refs, const Split& split, const AABB& bounds, std::vector<Reference>& left, std::vector<Reference>& right) const;
+    };
+
+    static void setAxis(Vector3& v, int axis, float value) {
+        if (axis == 0) v.x = value;
+        else if (axis == 1) v.y = value;
+        else v.z = value;
+    }
+
+    static AABB clipReference(const Reference& ref, const AABB& cell) {
+        return ref.object->getClippedBoundingBox(AABB::intersection(ref.bounds, cell));
+    }
+
+    Split Builder::findObjectSplit(const std::vector<Reference>& refs, const AABB& centroidBounds) const {
+        Split best;
+        const int binCount = settings.bins;
+        std::vector<BVHBin> bins(binCount);
+        std::vector<BVHBin> right(binCount);
+
+        for (int axis = 0; axis < 3; ++axis) {
+            float lower = centroidBounds.lower[axis];
+            float extent = centroidBounds.upper[axis] - lower;
+            if (extent <= 0) continue;
+
+            std::fill(bins.begin(), bins.end(), BVHBin());
+            for (const Reference& ref : refs) {
+                int bin = std::min((int)(binCount * (ref.bounds.center()[axis] - lower) / extent), binCount - 1);
+                bins[bin].add(ref.bounds);
+            }
+
+            // Sweep from the right, then evaluate each plane from the left
+            right[binCount - 1] = bins[binCount - 1];
+            for (int i = binCount - 2; i >= 0; --i) {
+                right[i] = right[i + 1];
+                right[i].add(bins[i]);
+            }
+            BVHBin left;
+            for (int i = 0; i < binCount - 1; ++i) {
+                left.add(bins[i]);
+                if (left.count == 0 || right[i + 1].count == 0) continue;
+
+                float cost = left.bounds.surfaceArea() * left.count + right[i + 1].bounds.surfaceArea() * right[i + 1].count;
+                if (cost < best.cost) {
+                    best.cost = cost;
+                    best.axis = axis;
+                    best.bin = i + 1;
+                    best.leftBounds = left.bounds;
+                    best.rightBounds = right[i + 1].bounds;
+                }
+            }
+        }
+        return best;
+    }
+
+    Split Builder::findSpatialSplit(const std::vector<Reference>& refs, const AABB& bounds) const {
+        Split best;
+        const int binCount = settings.bins;
+        std::vector<BVHBin> bins(binCount);
+        std::vector<BVHBin> right(binCount);
+        std::vector<size_t> entries(binCount);
+        std::vector<size_t> exits(binCount);
+
+        for (int axis = 0; axis < 3; ++axis) {
+            float lower = bounds.lower[axis];
+            float extent = bounds.upper[axis] - lower;
+            if (extent <= 0) continue;
+            float binWidth = extent / binCount;
+
+            std::fill(bins.begin(), bins.end(), BVHBin());
+            std::fill(entries.begin(), entries.end(), 0);
+            std::fill(exits.begin(), exits.end(), 0);
+
+            // Count where each reference starts and ends, bounding the part inside every bin it crosses
+            for (const Reference& ref : refs) {
+                int first = std::clamp((int)((ref.bounds.lower[axis] - lower) / binWidth), 0, binCount - 1);
+                int last = std::clamp((int)((ref.bounds.upper[axis] - lower) / binWidth), first, binCount - 1);
+                entries[first]++;
+                exits[last]++;
+
+                for (int i = first; i <= last; ++i) {
+                    AABB cell = bounds;
+                    setAxis(cell.lower, axis, lower + binWidth * i);
+                    if (i < binCount - 1) setAxis(cell.upper, axis, lower + binWidth * (i + 1));
+
+                    // Bin counts only mark bounds as set, the split counts come from entries and exits
+                    AABB clipped = clipReference(ref, cell);
+                    if (!clipped.isEmpty()) bins[i].add(clipped);
+                }
+            }
+
+            right[binCount - 1] = bins[binCount - 1];
+            for (int i = binCount - 2; i >= 0; --i) {
+                right[i] = right[i + 1];
+                right[i].add(bins[i]);
+            }
+            BVHBin left;
+            size_t leftCount = 0;
+            size_t rightCount = refs.size();
+            for (int i = 0; i < binCount - 1; ++i) {
+                left.add(bins[i]);
+                leftCount += entries[i];
+                rightCount -= exits[i];
+                if (leftCount == 0 || rightCount == 0 || left.count == 0 || right[i + 1].count == 0) continue;
+
+                float cost = left.bounds.surfaceArea() * leftCount + right[i + 1].bounds.surfaceArea() * rightCount;
+                if (cost < best.cost) {
+                    best.cost = cost;
+                    best.axis = axis;
+                    best.position = lower + binWidth * (i + 1);
+                    best.leftBounds = left.bounds;
+                    best.rightBounds = right[i + 1].bounds;
+                }
+            }
+        }
+        return best;
+    }
+
+    size_t Builder::splitSpatial(std::vector<Reference>& refs, const Split& split, const AABB& bounds, std::vector<Reference>& left, std::vector<Reference>& right) const {
+        size_t duplicates = 0;
+        AABB leftCell = bounds;
+        AABB rightCell = bounds;
+        setAxis(leftCell.upper, split.axis, split.position);
+        setAxis(rightCell.lower, split.axis, split.position);
+
+        for (const Reference& ref : refs) {
+            if (ref.bounds.upper[split.axis] <= split.position) {
+                left.push_back(ref);
+            } else if (ref.bounds.lower[split.axis] >= split.position) {
+                right.push_back(ref);
+            } else if (referenceCount + duplicates < referenceLimit) {
+                // Straddles the plane, reference both halves
+                AABB leftPart = clipReference(ref, leftCell);
+                AABB rightPart = clipReference(ref, rightCell);
+                if (leftPart.isEmpty()) {
+                    right.push_back(ref);
+                } else if (rightPart.isEmpty()) {
+                    left.push_back(ref);
+                } else {
+                    left.push_back({ ref.object, leftPart });
+                    right.push_back({ ref.object, rightPart });
+                    duplicates++;
+                }
+            } else if (ref.bounds.center()[split.axis] < split.position) {
+                // Out of budget, keep whole on the side holding its center
+                left.push_back(ref);
+            } else {
+                right.push_back(ref);
+            }
+        }
+        return duplicates;
+    }
+
+    std::unique_ptr<BVHNode> Builder::build(std::vector<Reference>& refs, int depth) {
+        auto node = make_unique<BVHNode>();
+        size_t count = refs.size();
+
+        AABB centroidBounds = { refs[0].bounds.center(), refs[0].bounds.center() };
+        node->bounds = refs[0].bounds;
+        for (const Reference& ref : refs) {
+            node->bounds = AABB::combine(node->bounds, ref.bounds);
+            centroidBounds = AABB::combine(centroidBounds, { ref.bounds.center(), ref.bounds.center() });
+        }
+        float area = node->bounds.surfaceArea();
+
+        // Median splits halve the count every level, use only those once anything else could run out of depth first
+        int medianLevels = 0;
+        while (((size_t)1 << medianLevels) < count) medianLevels++;
+        bool medianOnly = depth + medianLevels >= LinearBVH::STACK_SIZE - 1;
+
+        Split best = medianOnly ? Split() : findObjectSplit(refs, centroidBounds);
+        bool spatial = false;
+
+        // Only try spatial splits where the object split children overlap enough to matter
+        if (!medianOnly && referenceCount < referenceLimit && count > 1) {
+            AABB overlap = AABB::intersection(best.leftBounds, best.rightBounds);
+            float overlapArea = best.axis == -1 || overlap.isEmpty() ? 0 : overlap.surfaceArea();
+            if (best.axis == -1 || overlapArea > settings.spatialSplitAlpha * rootArea) {
+                Split spatialSplit = findSpatialSplit(refs, node->bounds);
+                if (spatialSplit.cost < best.cost) {
+                    best = spatialSplit;
+                    spatial = true;
+                }
+            }
+        }
+
+        // Leaf
+        float leafCost = settings.intersectionCost * count;
+        float splitCost = area > 0 ? settings.traversalCost + settings.intersectionCost * best.cost / area : FLT_MAX;
+        bool tooDeep = depth >= LinearBVH::STACK_SIZE - 1;
+        if (count <= 1 || tooDeep || (count <= (size_t)settings.maxLeafSize && leafCost <= splitCost)) {
+            node->start = leaves.size();
+            node->count = count;
+            for (const Reference& ref : refs) leaves.push_back(ref.object);
+            return node;
+        }
+
+        std::vector<Reference> left;
+        std::vector<Reference> right;
+        size_t duplicates = 0;
+        if (spatial) {
+            duplicates = splitSpatial(refs, best, node->bounds, left, right);
+        } else if (best.axis != -1) {
+            float lower = centroidBounds.lower[best.axis];
+            float extent = centroidBounds.upper[best.axis] - lower;
+            for (const Reference& ref : refs) {
+                int bin = std::min((int)(settings.bins * (ref.bounds.center()[best.axis] - lower) / extent), settings.bins - 1);
+                (bin < best.bin ? left : right).push_back(ref);
+            }
+        }
+
+        // Degenerate split, fall back to the median centroid
+        if (left.empty() || right.empty() || left.size() == count || right.size() == count) {
+            left.clear();
+            right.clear();
+            Vector3 extent = centroidBounds.upper - centroidBounds.lower;
+            int axis = extent.x > extent.y && extent.x > extent.z ? 0 : (extent.y > extent.z ? 1 : 2);
+            std::nth_element(refs.begin(), refs.begin() + count / 2, refs.end(), [axis](const Reference& a, const Reference& b) {
+                return a.bounds.center()[axis] < b.bounds.center()[axis];
+            });
+            left.assign(refs.begin(), refs.begin() + count / 2);
+            right.assign(refs.begin() + count / 2, refs.end());
+            duplicates = 0;
+        }
+        referenceCount += duplicates;
+        refs.clear();
+        refs.shrink_to_fit();
+
+        // Build left/right
+        node->left = build(left, depth + 1);
+        node->right = build(right, depth + 1);
+        return node;
+    }
+
+    std::unique_ptr<BVHNode> build(vector<Hittable*>& objects, const BVHBuildSettings& settings) {
+        if (objects.empty()) return make_unique<BVHNode>();
+
+        std::vector<Reference> refs;
+        refs.reserve(objects.size());
+        AABB rootBounds = objects[0]->getBoundingBox();
+        for (Hittable* object : objects) {
+            refs.push_back({ object, object->getBoundingBox() });
+            rootBounds = AABB::combine(rootBounds, refs.back().bounds);
+        }
+
+        Builder builder(settings);
+        builder.rootArea = rootBounds.surfaceArea();
+        builder.referenceCount = objects.size();
+        builder.referenceLimit = objects.size() + (size_t)(objects.size() * std::max(settings.maxDuplication, 0.0f));
+        builder.leaves.reserve(builder.referenceLimit);
+
+        std::unique_ptr<BVHNode> root = builder.build(refs, 1);
+        objects.swap(builder.leaves);
+        return root;
+    }
+}
\ No newline at end of file
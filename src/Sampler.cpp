@@ -0,0 +1,92 @@
+#include "Sampler.h"
+#include <array>
+
+static float toFloat(uint32_t bits) {
+    return (bits >> 8) * 0x1p-24f;
+}
+
+void IndependentSampler::startSample(uint32_t x, uint32_t y, uint32_t index) {
+    rng = PCG32::forSample(x, y, index, seed);
+}
+float IndependentSampler::get1D() {
+    return rng.nextFloat();
+}
+Sample2D IndependentSampler::get2D() {
+    float u = rng.nextFloat();
+    return { u, rng.nextFloat() };
+}
+
+// Integer hash with low bias (Wellons)
+static uint32_t hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+static uint32_t hashCombine(uint32_t seed, uint32_t v) {
+    return seed ^ (hash(v) + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+
+static uint32_t reverseBits(uint32_t x) {
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+    x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+    x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+    return x;
+}
+
+// Permutes bits so each only depends on the bits below it, an Owen scramble of the reversed value
+static uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed) {
+    x ^= x * 0x3d20adeau;
+    x += seed;
+    x *= (seed >> 16) | 1;
+    x ^= x * 0x05526c56u;
+    x ^= x * 0x53a22864u;
+    return x;
+}
+
+// Second Sobol dimension with its bits reversed, the first is the reversed index itself.
+// Both are scrambled in reversed order, so keeping them that way saves reversing twice
+static uint32_t sobol1Reversed(uint32_t index) {
+    // Linear in the index bits, so a table per index byte replaces the 32 step loop
+    static const auto tables = []() {
+        std::array<std::array<uint32_t, 256>, 4> t{};
+        uint32_t directions[32];
+        directions[0] = 1u << 31;
+        for (int i = 1; i < 32; ++i) directions[i] = directions[i - 1] ^ (directions[i - 1] >> 1);
+
+        for (int byte = 0; byte < 4; ++byte) {
+            for (uint32_t value = 0; value < 256; ++value) {
+                for (int bit = 0; bit < 8; ++bit) {
+                    if (value & (1u << bit)) t[byte][value] ^= reverseBits(directions[byte * 8 + bit]);
+                }
+            }
+        }
+        return t;
+    }();
+    return tables[0][index & 0xff] ^ tables[1][(index >> 8) & 0xff] ^ tables[2][(index >> 16) & 0xff] ^ tables[3][index >> 24];
+}
+
+void SobolSampler::startSample(uint32_t x, uint32_t y, uint32_t index) {
+    pixelSeed = hashCombine(hashCombine(seed, x), y);
+    reversedIndex = reverseBits(index);
+    dimension = 0;
+}
+float SobolSampler::get1D() {
+    uint32_t dimensionSeed = hashCombine(pixelSeed, dimension++);
+    uint32_t shuffled = reverseBits(laineKarrasPermutation(reversedIndex, dimensionSeed));
+    return toFloat(reverseBits(laineKarrasPermutation(shuffled, hash(dimensionSeed))));
+}
+Sample2D SobolSampler::get2D() {
+    // Shuffle the sample order, then scramble both dimensions
+    uint32_t dimensionSeed = hashCombine(pixelSeed, dimension++);
+    uint32_t shuffled = reverseBits(laineKarrasPermutation(reversedIndex, dimensionSeed));
+    uint32_t uSeed = hash(dimensionSeed);
+    return {
+        toFloat(reverseBits(laineKarrasPermutation(shuffled, uSeed))),
+        toFloat(reverseBits(laineKarrasPermutation(sobol1Reversed(shuffled), hash(uSeed))))
+    };
+}
\ No newline at end of file
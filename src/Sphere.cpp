@@ -31,15 +31,82 @@ bool Sphere::intersectsRay(const Ray& ray, double& outT) const {
     outT = t;
     return true;
 }
-Vector3d Sphere::getNormalAt(const Vector3d& point, const Vector3d& dir) const {
+Vector3d Sphere::getNormalAt(const Vector3d& point, const Vector3d&, const HitRecord&) const {
     Vector3d normal = (point - center).normalized();
     return normal;
 }
 
+bool Sphere::intersect(const Ray& ray, HitRecord& hit, int&) const {
+    double t;
+    if (!Sphere::intersectsRay(ray, t) || t >= hit.t) return false;
+    hit = { t, this, this };
+    return true;
+}
+
+bool Sphere::occludes(const Ray& ray, double tMin, double tMax, int&) const {
+    double t;
+    return Sphere::intersectsRay(ray, t) && t > tMin && t < tMax;
+}
+
 AABB Sphere::getBoundingBox() const {
     return { center - Vector3(radius), center + Vector3(radius) };
 }
 
+double Sphere::getArea() const {
+    return 4.0 * Utilities::PI * radiusSquared;
+}
+
+bool Sphere::sampleSurface(const Vector3d& from, const Sample2D& sample, Vector3d& outPoint, Vector3d& outNormal, double& outPdf) const {
+    Vector3d toCenter = Vector3d(center) - from;
+    double distanceSquared = toCenter.lengthSquared();
+
+    // Inside, any point can be seen so sample by area
+    if (distanceSquared <= radiusSquared) {
+        double z = 1.0 - 2.0 * sample.u;
+        double ring = sqrt(std::max(0.0, 1.0 - z * z));
+        double phi = 2.0 * Utilities::PI * sample.v;
+        outNormal = Vector3d(cos(phi) * ring, sin(phi) * ring, z);
+        outPoint = Vector3d(center) + outNormal * radius;
+        outPdf = getSurfacePdf(from, outPoint);
+        return outPdf > 0;
+    }
+
+    // Outside, sample the cone of directions the sphere covers
+    double distance = sqrt(distanceSquared);
+    double cosMax = sqrt(std::max(0.0, 1.0 - radiusSquared / distanceSquared));
+    if (1.0 - cosMax <= 0) return false;
+
+    double cosTheta = 1.0 - sample.u * (1.0 - cosMax);
+    double sinTheta = sqrt(std::max(0.0, 1.0 - cosTheta * cosTheta));
+    double phi = 2.0 * Utilities::PI * sample.v;
+
+    Vector3d w = toCenter / distance;
+    Vector3d a = (fabs(w.x) > 0.9) ? Vector3d(0.0, 1.0, 0.0) : Vector3d(1.0, 0.0, 0.0);
+    Vector3d v = w.cross(a).normalized();
+    Vector3d u = v.cross(w);
+    Vector3d direction = u * (cos(phi) * sinTheta) + v * (sin(phi) * sinTheta) + w * cosTheta;
+
+    // Nearest point along the direction
+    double along = distance * cosTheta - sqrt(std::max(0.0, radiusSquared - distanceSquared * sinTheta * sinTheta));
+    outPoint = from + direction * along;
+    outNormal = (outPoint - Vector3d(center)).normalized();
+    outPdf = 1.0 / (2.0 * Utilities::PI * (1.0 - cosMax));
+    return true;
+}
+
+double Sphere::getSurfacePdf(const Vector3d& from, const Vector3d& point) const {
+    double distanceSquared = (Vector3d(center) - from).lengthSquared();
+    if (distanceSquared > radiusSquared) {
+        double cosMax = sqrt(std::max(0.0, 1.0 - radiusSquared / distanceSquared));
+        return 1.0 - cosMax > 0 ? 1.0 / (2.0 * Utilities::PI * (1.0 - cosMax)) : 0;
+    }
+
+    // Area pdf converted to solid angle
+    Vector3d toPoint = point - from;
+    double cosine = fabs((point - Vector3d(center)).normalized().dot(toPoint.normalized()));
+    return cosine > 0 ? toPoint.lengthSquared() / (cosine * getArea()) : 0;
+}
+
 //std::tuple<float, float> Sphere::getUV(const Vector3& point) const {
 //    Vector3 d = (point - center).normalized();
 //    float u = 0.5f + atan2(d.z, d.x) / (2 * Utilities::PI);
@@ -0,0 +1,75 @@
+#include "Threading.h"
+#include "Constants.h"
+#include <cstdlib>
+#include <thread>
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Threading {
+    static unsigned getHardwareThreads() {
+#if defined(__linux__)
+        // Respects taskset and container limits, unlike hardware_concurrency
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0)
+            return (unsigned)CPU_COUNT(&set);
+#endif
+        unsigned hardware = std::thread::hardware_concurrency();
+        return hardware > 0 ? hardware : 4;
+    }
+
+    unsigned getThreadCount() {
+        static const unsigned count = [] {
+            if (const char* value = std::getenv("PATHTRACER_THREADS")) {
+                int threads = std::atoi(value);
+                if (threads > 0) return (unsigned)threads;
+            }
+            return THREADS > 0 ? THREADS : getHardwareThreads();
+        }();
+        return count;
+    }
+
+#if defined(_WIN32)
+    bool pinCurrentThread(unsigned index) {
+        DWORD_PTR processMask, systemMask;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) || processMask == 0) return false;
+
+        // The index-th allowed core, wrapping when there are more threads than cores
+        int allowed = 0;
+        for (DWORD_PTR bits = processMask; bits; bits &= bits - 1) allowed++;
+        unsigned target = index % allowed;
+        for (int bit = 0; bit < (int)sizeof(DWORD_PTR) * 8; ++bit) {
+            DWORD_PTR mask = (DWORD_PTR)1 << bit;
+            if (!(processMask & mask)) continue;
+            if (target-- == 0) return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+        }
+        return false;
+    }
+#elif defined(__linux__)
+    bool pinCurrentThread(unsigned index) {
+        cpu_set_t allowed;
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) return false;
+
+        // The index-th allowed core, wrapping when there are more threads than cores
+        unsigned target = index % (unsigned)CPU_COUNT(&allowed);
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (!CPU_ISSET(cpu, &allowed)) continue;
+            if (target-- == 0) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+            }
+        }
+        return false;
+    }
+#else
+    bool pinCurrentThread(unsigned) {
+        return false;
+    }
+#endif
+}
\ No newline at end of file
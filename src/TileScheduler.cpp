@@ -0,0 +1,189 @@
+#include "TileScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TileScheduler::TileScheduler(int tilesX, int tilesY, unsigned threads, int coarseSize)
+    : tilesX(tilesX), tilesY(tilesY), coarseSize(std::max(1, coarseSize)), threadCount(std::max(1u, threads)),
+    workers(new Worker[std::max(1u, threads)]),
+    lastCosts(new std::atomic<double>[tilesX * tilesY]), totalCosts(new std::atomic<double>[tilesX * tilesY]) {
+    for (int i = 0; i < tilesX * tilesY; ++i) {
+        lastCosts[i] = -1; // not timed yet
+        totalCosts[i] = 0;
+    }
+}
+
+void TileScheduler::start(int firstPass, PassCheck check) {
+    morePasses = std::move(check);
+    dealtAll = false;
+    stopped = false;
+    deal(firstPass);
+}
+
+void TileScheduler::deal(int dealtPass) {
+    std::vector<TileRange> coarse;
+    for (int y = 0; y < tilesY; y += coarseSize) {
+        for (int x = 0; x < tilesX; x += coarseSize) {
+            coarse.push_back({ x, y, std::min(x + coarseSize, tilesX), std::min(y + coarseSize, tilesY), dealtPass });
+        }
+    }
+
+    // Costs from the latest passes, tiles not timed yet count as the average
+    std::vector<double> costs(coarse.size(), 0.0);
+    double known = 0;
+    int knownCount = 0;
+    for (int i = 0; i < tilesX * tilesY; ++i) {
+        if (lastCosts[i] >= 0) {
+            known += lastCosts[i];
+            knownCount++;
+        }
+    }
+    double average = knownCount > 0 ? known / knownCount : 1.0;
+    double total = 0;
+    for (size_t r = 0; r < coarse.size(); ++r) {
+        for (int y = coarse[r].y0; y < coarse[r].y1; ++y) {
+            for (int x = coarse[r].x0; x < coarse[r].x1; ++x) {
+                double cost = lastCosts[y * tilesX + x];
+                costs[r] += cost >= 0 ? cost : average;
+            }
+        }
+        total += costs[r];
+    }
+
+    // Count before the ranges can be taken. Contiguous runs keep each thread's tiles close together
+    remaining = tilesX * tilesY;
+    pass = dealtPass;
+    size_t begin = 0;
+    double dealt = 0;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        size_t end = begin;
+        double share = total * (t + 1) / threadCount;
+        while (end < coarse.size() && (t + 1 == threadCount || dealt + costs[end] * .5 <= share)) {
+            dealt += costs[end++];
+        }
+
+        Worker& worker = workers[t];
+        std::lock_guard<std::mutex> lock(worker.lock);
+        worker.ranges.insert(worker.ranges.end(), coarse.begin() + begin, coarse.begin() + end);
+        begin = end;
+    }
+}
+
+bool TileScheduler::advance(int handedOutPass) {
+    std::lock_guard<std::mutex> lock(passLock);
+    if (dealtAll) return false;
+    if (pass != handedOutPass) return true; // another thread got here first
+    if (stopped || !morePasses(handedOutPass + 1)) {
+        // Not a stop, threads holding tiles of the last pass still render them
+        dealtAll = true;
+        return false;
+    }
+    deal(handedOutPass + 1);
+    return true;
+}
+
+bool TileScheduler::take(unsigned thread) {
+    Worker& self = workers[thread];
+    TileRange range;
+    bool found = false;
+    {
+        // Own deque from the back
+        std::lock_guard<std::mutex> lock(self.lock);
+        if (!self.ranges.empty()) {
+            range = self.ranges.back();
+            self.ranges.pop_back();
+            found = true;
+        }
+    }
+
+    // Others from the front, where the largest ranges are
+    for (unsigned i = 1; i < threadCount && !found; ++i) {
+        Worker& victim = workers[(thread + i) % threadCount];
+        std::lock_guard<std::mutex> lock(victim.lock);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            found = true;
+            steals++;
+        }
+    }
+
+    if (!found) return false;
+    self.current = range;
+    self.cursorX = range.x0;
+    self.cursorY = range.y0;
+    return true;
+}
+
+void TileScheduler::splitCurrent(Worker& worker) {
+    // Keep something to steal once the deque runs dry
+    std::lock_guard<std::mutex> lock(worker.lock);
+    if (!worker.ranges.empty()) return;
+
+    // What is left is the rest of the cursor row and the rows below, give away from the end
+    TileRange& current = worker.current;
+    TileRange other = current;
+    int rowsBelow = current.y1 - worker.cursorY - 1;
+    if (rowsBelow > 0) {
+        other.y0 = current.y1 - (rowsBelow + 1) / 2;
+        current.y1 = other.y0;
+    }
+    else if (current.x1 - worker.cursorX > 1) {
+        other.x0 = worker.cursorX + (current.x1 - worker.cursorX + 1) / 2;
+        other.y0 = worker.cursorY;
+        current.x1 = other.x0;
+    }
+    else {
+        return;
+    }
+    worker.ranges.push_back(other);
+    splits++;
+}
+
+bool TileScheduler::next(unsigned thread, int& outTile, int& outPass) {
+    Worker& self = workers[thread];
+    if (stopped) return false;
+
+    if (self.cursorY >= self.current.y1 && !take(thread)) {
+        // The rest is held by threads that split off part of their range once their deque is empty
+        bool found = false;
+        for (int attempt = 0; !found && !stopped; ++attempt) {
+            int seenPass = pass;
+            if (remaining == 0 && !advance(seenPass)) break;
+            found = take(thread);
+
+            // Back off so waiting threads don't take time from working ones on a busy machine
+            if (found) break;
+            if (attempt < 64) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        if (!found) return false;
+    }
+
+    splitCurrent(self);
+
+    outTile = self.cursorY * tilesX + self.cursorX;
+    outPass = self.current.pass;
+    if (++self.cursorX >= self.current.x1) {
+        self.cursorX = self.current.x0;
+        self.cursorY++;
+    }
+    remaining--;
+    return true;
+}
+
+void TileScheduler::stop() {
+    stopped = true;
+}
+
+std::vector<TileRange> TileScheduler::getDealt(unsigned thread) {
+    Worker& worker = workers[thread];
+    std::lock_guard<std::mutex> lock(worker.lock);
+    return std::vector<TileRange>(worker.ranges.begin(), worker.ranges.end());
+}
+
+void TileScheduler::recordTile(int tile, double seconds) {
+    lastCosts[tile] = seconds;
+    totalCosts[tile] = totalCosts[tile] + seconds;
+}
\ No newline at end of file
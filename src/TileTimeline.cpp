@@ -0,0 +1,30 @@
+#include "TileTimeline.h"
+#include <fstream>
+
+TileTimeline::TileTimeline(unsigned threads, std::chrono::steady_clock::time_point begin)
+    : begin(begin), threads(new ThreadEvents[threads]), threadCount(threads) {}
+
+void TileTimeline::record(unsigned thread, const char* name, int tile, int pass, int samples, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    using namespace std::chrono;
+    threads[thread].events.push_back({ name, tile, pass, samples, duration<double>(start - begin).count(), duration<double>(end - begin).count() });
+}
+
+bool TileTimeline::write(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    // Complete events ("X") in microseconds, one track per thread
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << t << ",\"args\":{\"name\":\"Render thread " << t << "\"}}";
+        first = false;
+        for (const Event& event : threads[t].events) {
+            file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"render\",\"ph\":\"X\",\"pid\":0,\"tid\":" << t
+                << ",\"ts\":" << (long long)(event.start * 1e6) << ",\"dur\":" << (long long)((event.end - event.start) * 1e6)
+                << ",\"args\":{\"tile\":" << event.tile << ",\"pass\":" << event.pass << ",\"samples\":" << event.samples << "}}";
+        }
+    }
+    file << "\n]}\n";
+    return (bool)file;
+}
\ No newline at end of file
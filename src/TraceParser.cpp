@@ -105,11 +105,37 @@ static std::string handleReadObj(const std::string& scope, std::istringstream& l
     if (scene.materials.find(matString) == scene.materials.end())
         return "Could not find PTS defined Material '" + matString + "'";
     auto loadedScene = Utilities::readObjFile(file, scene.materials[matString], scale, offset);
+    scene.files.push_back(file);
     scene.hittables.insert(scene.hittables.end(), std::make_move_iterator(loadedScene.begin()), std::make_move_iterator(loadedScene.end()));
 
     return "";
 }
 
+static std::string handleReadInstance(const std::string& scope, std::istringstream& linereader, SceneSetup& scene, ssMap& localVariables, ssMap& globalVariables) {
+    if (scope != "read")
+        return "Key 'instance:' should be in scope 'read'";
+
+    std::string file, matString;
+    float scale;
+    Vector3 offset, rotation;
+
+    if (!(linereader >> file >> scale >> offset >> rotation >> matString))
+        return "Expected 'string float Vector3 Vector3 Material'";
+    if (scene.materials.find(matString) == scene.materials.end())
+        return "Could not find PTS defined Material '" + matString + "'";
+
+    // Load and build each mesh once, every instance traces it with its own material in place of the triangles'
+    auto mesh = scene.meshes.find(file);
+    if (mesh == scene.meshes.end()) {
+        auto triangles = Utilities::readObjFile(file, scene.materials[matString]);
+        mesh = scene.meshes.emplace(file, std::make_shared<Mesh>(std::move(triangles))).first;
+        scene.files.push_back(file);
+    }
+    scene.hittables.push_back(std::make_unique<Instance>(mesh->second, scale, offset, rotation, scene.materials[matString]));
+
+    return "";
+}
+
 static std::string handleReadTrc(const std::string& scope, std::istringstream& linereader, SceneSetup& scene, ssMap& localVariables, ssMap& globalVariables) {
     if (scope != "read")
         return "Key 'trc:' should be in scope 'read'";
@@ -124,6 +150,10 @@ static std::string handleReadTrc(const std::string& scope, std::istringstream& l
     scene.hittables.insert(scene.hittables.end(), std::make_move_iterator(loadedScene.hittables.begin()), std::make_move_iterator(loadedScene.hittables.end()));
     // Materials
     scene.materials.insert(loadedScene.materials.begin(), loadedScene.materials.end());
+    // Meshes
+    scene.meshes.insert(loadedScene.meshes.begin(), loadedScene.meshes.end());
+    // Files
+    scene.files.insert(scene.files.end(), loadedScene.files.begin(), loadedScene.files.end());
 
     return "";
 }
@@ -161,6 +191,7 @@ const std::vector <TraceKey> TraceParser::traceKeys = {
         TraceKey("triangle:", "objects", handleObjectsTriangle),
         TraceKey("sphere:", "objects", handleObjectsSphere),
         TraceKey("obj:", "read", handleReadObj),
+        TraceKey("instance:", "read", handleReadInstance),
         TraceKey("trc:", "read", handleReadTrc),
         TraceKey("local:", "variables", handleVariablesLocal),
         TraceKey("global:", "variables", handleVariablesGlobal),
@@ -263,6 +294,7 @@ SceneSetup TraceParser::readTrcFile(const std::string& filename) {
     ssMap localVariables;
     if (!filereader)
         throw std::runtime_error("Unable to open file: " + filename);
+    scene.files.push_back(filename);
 
     // Iterate lines
     std::vector<std::string> ifSkips;
@@ -16,7 +16,8 @@ Triangle::Triangle(const Vector3& v0, const Vector3& v1, const Vector3& v2, std:
 }
 bool Triangle::intersectsRay(const Ray& ray, double& outT) const {
     // Cull backface if opaque
-    if (material->refractiveIndex == 1.0f && normal.dot(ray.direction) >= 0) return false;
+    const Material& surface = ray.material ? *ray.material : *material;
+    if (surface.refractiveIndex == 1.0f && normal.dot(ray.direction) >= 0) return false;
 
     // Edges
     Vector3d edge1 = v1 - v0;
@@ -47,10 +48,22 @@ bool Triangle::intersectsRay(const Ray& ray, double& outT) const {
     return false; // Ray doesn't intersect
 }
 
-Vector3d Triangle::getNormalAt(const Vector3d& point, const Vector3d& dir) const {
+Vector3d Triangle::getNormalAt(const Vector3d&, const Vector3d&, const HitRecord&) const {
     return normal;
 }
 
+bool Triangle::intersect(const Ray& ray, HitRecord& hit, int&) const {
+    double t;
+    if (!Triangle::intersectsRay(ray, t) || t >= hit.t) return false;
+    hit = { t, this, this };
+    return true;
+}
+
+bool Triangle::occludes(const Ray& ray, double tMin, double tMax, int&) const {
+    double t;
+    return Triangle::intersectsRay(ray, t) && t > tMin && t < tMax;
+}
+
 AABB Triangle::getBoundingBox() const {
     return { Vector3(
         min({ v0.x, v1.x, v2.x }),
@@ -63,4 +76,71 @@ AABB Triangle::getBoundingBox() const {
         max({ v0.z, v1.z, v2.z })
     ),
     };
+}
+
+AABB Triangle::getClippedBoundingBox(const AABB& clip) const {
+    // Clip against each face of the box in turn, a triangle gains at most one vertex per face
+    Vector3d polygon[9] = { v0, v1, v2 };
+    Vector3d clipped[9];
+    int count = 3;
+
+    for (int axis = 0; axis < 3 && count > 0; ++axis) {
+        for (int side = 0; side < 2 && count > 0; ++side) {
+            double plane = side == 0 ? clip.lower[axis] : clip.upper[axis];
+            int clippedCount = 0;
+
+            for (int i = 0; i < count; ++i) {
+                const Vector3d& a = polygon[i];
+                const Vector3d& b = polygon[(i + 1) % count];
+                bool aInside = side == 0 ? a[axis] >= plane : a[axis] <= plane;
+                bool bInside = side == 0 ? b[axis] >= plane : b[axis] <= plane;
+
+                if (aInside) clipped[clippedCount++] = a;
+                if (aInside != bInside) clipped[clippedCount++] = a + (b - a) * ((plane - a[axis]) / (b[axis] - a[axis]));
+            }
+
+            std::copy(clipped, clipped + clippedCount, polygon);
+            count = clippedCount;
+        }
+    }
+
+    if (count == 0) return AABB::intersection(getBoundingBox(), clip);
+
+    AABB bounds = { polygon[0], polygon[0] };
+    for (int i = 1; i < count; ++i) {
+        bounds = AABB::combine(bounds, { polygon[i], polygon[i] });
+    }
+    // Rounding can put intersection points just outside
+    return AABB::intersection(bounds, clip);
+}
+
+double Triangle::getArea() const {
+    return 0.5 * Vector3d(v1 - v0).cross(Vector3d(v2 - v0)).length();
+}
+
+bool Triangle::sampleSurface(const Vector3d& from, const Sample2D& sample, Vector3d& outPoint, Vector3d& outNormal, double& outPdf) const {
+    // Uniform over the area
+    double root = sqrt(sample.u);
+    double b0 = 1.0 - root;
+    double b1 = sample.v * root;
+    outPoint = Vector3d(v0) * b0 + Vector3d(v1) * b1 + Vector3d(v2) * (1.0 - b0 - b1);
+    outNormal = normal;
+    outPdf = getSurfacePdf(from, outPoint);
+    return outPdf > 0;
+}
+
+double Triangle::getSurfacePdf(const Vector3d& from, const Vector3d& point) const {
+    Vector3d toPoint = point - from;
+    double cosine = -normal.dot(toPoint.normalized());
+
+    // Opaque triangles are only hit from the front
+    if (!material->isDielectric() && cosine <= 0) return 0;
+    cosine = fabs(cosine);
+    return cosine > 0 ? toPoint.lengthSquared() / (cosine * getArea()) : 0;
+}
+
+DirectionCone Triangle::getNormalCone() const {
+    // Opaque triangles only emit from the front
+    if (material->isDielectric()) return Hittable::getNormalCone();
+    return { normal, 1.0 };
 }
\ No newline at end of file
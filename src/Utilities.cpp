@@ -8,6 +8,8 @@
 #include <string>
 #include <unordered_map>
 #include <algorithm>
+#include <functional>
+#include <thread>
 
 namespace Utilities {
     std::string readFile(const std::string& filename) {
@@ -22,25 +24,28 @@ namespace Utilities {
     }
 
     float randomFloat() {
-        static std::mt19937 rng(std::random_device{}());
-        static std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-        return dist(rng);
+        thread_local PCG32 rng(std::random_device{}(), std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        return rng.nextFloat();
     }
 
     Color randomColor() {
         return Color(randomFloat(), randomFloat(), randomFloat());
     }
 
-    Vector3d randomInUnitSphere() {
-        while (true) {
-            Vector3 p(randomFloat() * 2 - 1, randomFloat() * 2 - 1, randomFloat() * 2 - 1);
-            if (p.lengthSquared() < 1) return p;
-        }
+    Vector3d randomInUnitSphere(Sampler& sampler) {
+        // Uniform direction, radius weighted by volume
+        Sample2D direction = sampler.get2D();
+        double z = 1.0 - 2.0 * direction.u;
+        double ring = sqrt(std::max(0.0, 1.0 - z * z));
+        double phi = 2.0 * Utilities::PI * direction.v;
+        double radius = cbrt(sampler.get1D());
+        return Vector3d(cos(phi) * ring, sin(phi) * ring, z) * radius;
     }
 
-    Vector3d randomCosineHemisphere(const Vector3d& normal) {
-        double r1 = 2.0 * Utilities::PI * ((double)rand() / RAND_MAX);
-        double r2 = (double)rand() / RAND_MAX;
+    Vector3d randomCosineHemisphere(const Vector3d& normal, Sampler& sampler) {
+        Sample2D sample = sampler.get2D();
+        double r1 = 2.0 * Utilities::PI * sample.u;
+        double r2 = sample.v;
         double r2s = sqrt(r2);
 
         double x = cos(r1) * r2s;
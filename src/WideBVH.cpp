@@ -0,0 +1,266 @@
+#include "WideBVH.h"
+#include "RenderStats.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+template <int Width>
+WideBVH<Width>::WideBVH(const LinearBVH& bvh) : primitives(bvh.primitives) {
+    if (bvh.nodeCount > 0) collapse(bvh, 0);
+}
+
+template <int Width>
+int WideBVH<Width>::collapse(const LinearBVH& bvh, int binaryNode) {
+    // Open the largest interior child until every slot is used
+    int children[Width];
+    int childCount = 0;
+    if (bvh.nodes[binaryNode].count > 0) {
+        children[childCount++] = binaryNode; // Leaf root
+    } else {
+        children[childCount++] = binaryNode + 1;
+        children[childCount++] = bvh.nodes[binaryNode].offset;
+    }
+
+    while (childCount < Width) {
+        int largest = -1;
+        float largestArea = -1;
+        for (int i = 0; i < childCount; ++i) {
+            const LinearBVHNode& node = bvh.nodes[children[i]];
+            if (node.count == 0 && node.bounds.surfaceArea() > largestArea) {
+                largest = i;
+                largestArea = node.bounds.surfaceArea();
+            }
+        }
+        if (largest == -1) break;
+
+        int opened = children[largest];
+        children[largest] = opened + 1;
+        children[childCount++] = bvh.nodes[opened].offset;
+    }
+
+    int index = (int)nodes.size();
+    nodes.emplace_back();
+    {
+        WideBVHNode<Width>& node = nodes[index];
+        node.childCount = (uint8_t)childCount;
+        for (int i = 0; i < Width; ++i) {
+            const AABB bounds = i < childCount ? bvh.nodes[children[i]].bounds : AABB();
+            node.lowerX[i] = bounds.lower.x;
+            node.lowerY[i] = bounds.lower.y;
+            node.lowerZ[i] = bounds.lower.z;
+            node.upperX[i] = bounds.upper.x;
+            node.upperY[i] = bounds.upper.y;
+            node.upperZ[i] = bounds.upper.z;
+            node.child[i] = -1;
+            node.count[i] = 0;
+        }
+    }
+
+    // Recursing grows the node vector, so index again after each child
+    for (int i = 0; i < childCount; ++i) {
+        const LinearBVHNode& child = bvh.nodes[children[i]];
+        if (child.count > 0) {
+            nodes[index].child[i] = child.offset;
+            nodes[index].count[i] = child.count;
+        } else {
+            int wideChild = collapse(bvh, children[i]);
+            nodes[index].child[i] = wideChild;
+        }
+    }
+    return index;
+}
+
+template <int Width>
+int WideBVH<Width>::intersectChildrenScalar(const WideBVHNode<Width>& node, const float origin[3], const float invDir[3], float tMax, float* outNear) {
+    int mask = 0;
+    for (int i = 0; i < node.childCount; ++i) {
+        float t0x = (node.lowerX[i] - origin[0]) * invDir[0], t1x = (node.upperX[i] - origin[0]) * invDir[0];
+        float t0y = (node.lowerY[i] - origin[1]) * invDir[1], t1y = (node.upperY[i] - origin[1]) * invDir[1];
+        float t0z = (node.lowerZ[i] - origin[2]) * invDir[2], t1z = (node.upperZ[i] - origin[2]) * invDir[2];
+        float tNear = std::max({ std::min(t0x, t1x), std::min(t0y, t1y), std::min(t0z, t1z), 0.0f });
+        float tFar = std::min({ std::max(t0x, t1x), std::max(t0y, t1y), std::max(t0z, t1z), tMax });
+        outNear[i] = tNear;
+        if (tNear <= tFar) mask |= 1 << i;
+    }
+    return mask;
+}
+
+template <>
+int WideBVH<4>::intersectChildren(const WideBVHNode<4>& node, const float origin[3], const float invDir[3], float tMax, float* outNear) {
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128 ox = _mm_set1_ps(origin[0]), oy = _mm_set1_ps(origin[1]), oz = _mm_set1_ps(origin[2]);
+    const __m128 ix = _mm_set1_ps(invDir[0]), iy = _mm_set1_ps(invDir[1]), iz = _mm_set1_ps(invDir[2]);
+
+    __m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.lowerX), ox), ix);
+    __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.upperX), ox), ix);
+    __m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.lowerY), oy), iy);
+    __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.upperY), oy), iy);
+    __m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.lowerZ), oz), iz);
+    __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.upperZ), oz), iz);
+
+    __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)), _mm_max_ps(_mm_min_ps(t0z, t1z), _mm_setzero_ps()));
+    __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)), _mm_min_ps(_mm_max_ps(t0z, t1z), _mm_set1_ps(tMax)));
+
+    _mm_storeu_ps(outNear, tNear);
+    return _mm_movemask_ps(_mm_cmple_ps(tNear, tFar)) & ((1 << node.childCount) - 1);
+#else
+    return intersectChildrenScalar(node, origin, invDir, tMax, outNear);
+#endif
+}
+
+template <>
+int WideBVH<8>::intersectChildren(const WideBVHNode<8>& node, const float origin[3], const float invDir[3], float tMax, float* outNear) {
+#if defined(__AVX__)
+    const __m256 ox = _mm256_set1_ps(origin[0]), oy = _mm256_set1_ps(origin[1]), oz = _mm256_set1_ps(origin[2]);
+    const __m256 ix = _mm256_set1_ps(invDir[0]), iy = _mm256_set1_ps(invDir[1]), iz = _mm256_set1_ps(invDir[2]);
+
+    __m256 t0x = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.lowerX), ox), ix);
+    __m256 t1x = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.upperX), ox), ix);
+    __m256 t0y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.lowerY), oy), iy);
+    __m256 t1y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.upperY), oy), iy);
+    __m256 t0z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.lowerZ), oz), iz);
+    __m256 t1z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.upperZ), oz), iz);
+
+    __m256 tNear = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(t0x, t1x), _mm256_min_ps(t0y, t1y)), _mm256_max_ps(_mm256_min_ps(t0z, t1z), _mm256_setzero_ps()));
+    __m256 tFar = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(t0x, t1x), _mm256_max_ps(t0y, t1y)), _mm256_min_ps(_mm256_max_ps(t0z, t1z), _mm256_set1_ps(tMax)));
+
+    _mm256_storeu_ps(outNear, tNear);
+    return _mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)) & ((1 << node.childCount) - 1);
+#else
+    // Two SSE halves, or scalar without SSE
+    WideBVHNode<4> half;
+    int mask = 0;
+    for (int h = 0; h < 2; ++h) {
+        std::copy_n(node.lowerX + h * 4, 4, half.lowerX);
+        std::copy_n(node.lowerY + h * 4, 4, half.lowerY);
+        std::copy_n(node.lowerZ + h * 4, 4, half.lowerZ);
+        std::copy_n(node.upperX + h * 4, 4, half.upperX);
+        std::copy_n(node.upperY + h * 4, 4, half.upperY);
+        std::copy_n(node.upperZ + h * 4, 4, half.upperZ);
+        half.childCount = (uint8_t)std::clamp(node.childCount - h * 4, 0, 4);
+        mask |= WideBVH<4>::intersectChildren(half, origin, invDir, tMax, outNear + h * 4) << (h * 4);
+    }
+    return mask;
+#endif
+}
+
+template <int Width>
+bool WideBVH<Width>::intersect(const Ray& ray, HitRecord& hit, int& checks) const {
+    struct StackEntry {
+        int32_t index;
+        uint16_t count;
+        float boxT;
+    };
+
+    if (nodes.empty()) return false;
+
+    const float origin[3] = { (float)ray.origin.x, (float)ray.origin.y, (float)ray.origin.z };
+    const float invDir[3] = { (float)ray.invDirection.x, (float)ray.invDirection.y, (float)ray.invDirection.z };
+
+    RenderStats::TraversalCount count;
+    bool found = false;
+    StackEntry stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, 0, 0.0f };
+
+    while (stackSize > 0) {
+        const StackEntry entry = stack[--stackSize];
+        if (entry.boxT > hit.t) continue;
+
+        if (entry.count > 0) {
+            // Leaf
+            count.primitives += entry.count;
+            for (int i = entry.index; i < entry.index + entry.count; ++i) {
+                found |= primitives[i]->intersect(ray, hit, checks);
+            }
+            continue;
+        }
+
+        checks++;
+        count.nodes++;
+        const WideBVHNode<Width>& node = nodes[entry.index];
+        count.boxes += node.childCount;
+
+        // Widen the float far bound slightly so rounding can't cull the closest hit
+        float tMax = hit.t < FLT_MAX ? (float)hit.t * 1.0000004f : FLT_MAX;
+        alignas(32) float tNear[Width];
+        int mask = intersectChildren(node, origin, invDir, tMax, tNear);
+
+        // Push hit children farthest first so the nearest is visited next
+        int hits[Width];
+        int hitCount = 0;
+        while (mask) {
+            int i = 0;
+            while (!(mask & (1 << i))) ++i;
+            mask &= ~(1 << i);
+
+            int j = hitCount++;
+            while (j > 0 && tNear[hits[j - 1]] < tNear[i]) {
+                hits[j] = hits[j - 1];
+                --j;
+            }
+            hits[j] = i;
+        }
+        for (int h = 0; h < hitCount; ++h) {
+            int i = hits[h];
+            stack[stackSize++] = { node.child[i], node.count[i], tNear[i] };
+        }
+    }
+
+    return found;
+}
+
+template <int Width>
+bool WideBVH<Width>::occluded(const Ray& ray, double tMin, double tMax, int& checks) const {
+    struct StackEntry {
+        int32_t index;
+        uint16_t count;
+    };
+
+    if (nodes.empty()) return false;
+
+    const float origin[3] = { (float)ray.origin.x, (float)ray.origin.y, (float)ray.origin.z };
+    const float invDir[3] = { (float)ray.invDirection.x, (float)ray.invDirection.y, (float)ray.invDirection.z };
+    const float boxTMax = tMax < FLT_MAX ? (float)tMax * 1.0000004f : FLT_MAX;
+
+    RenderStats::TraversalCount count;
+    StackEntry stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, 0 };
+
+    while (stackSize > 0) {
+        const StackEntry entry = stack[--stackSize];
+
+        if (entry.count > 0) {
+            // Leaf, any hit in range ends the search
+            count.primitives += entry.count;
+            for (int i = entry.index; i < entry.index + entry.count; ++i) {
+                if (primitives[i]->occludes(ray, tMin, tMax, checks)) return true;
+            }
+            continue;
+        }
+
+        checks++;
+        count.nodes++;
+        const WideBVHNode<Width>& node = nodes[entry.index];
+        count.boxes += node.childCount;
+        alignas(32) float tNear[Width];
+        int mask = intersectChildren(node, origin, invDir, boxTMax, tNear);
+
+        // Any order will do
+        while (mask) {
+            int i = 0;
+            while (!(mask & (1 << i))) ++i;
+            mask &= ~(1 << i);
+            stack[stackSize++] = { node.child[i], node.count[i] };
+        }
+    }
+
+    return false;
+}
+
+template class WideBVH<4>;
+template class WideBVH<8>;
\ No newline at end of file
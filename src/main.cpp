@@ -7,16 +7,11 @@
 #include <memory>
 #include <random>
 #include <sstream>
-#include <omp.h>
 #include <string>
 #include <thread>
-#include <conio.h>
-#define NOMINMAX
-#include <Windows.h>
-#include <mmsystem.h>
+#include <csignal>
 #include <filesystem>
 #include <mutex>
-#pragma comment(lib, "winmm.lib")
 #include "lodepng.h"
 
 #include "Ray.h"
@@ -28,27 +23,37 @@
 #include "Constants.h"
 #include "BVHNode.h"
 #include "BVHStats.h"
+#include "BVHCache.h"
+#include "LinearBVH.h"
+#include "WideBVH.h"
 #include "TraceParser.h"
+#include "EmitterList.h"
+#include "Checkpoint.h"
+#include "TileScheduler.h"
+#include "FrameBuffer.h"
+#include "Threading.h"
+#include "RenderSettings.h"
+#include "RenderStats.h"
+#include "TileTimeline.h"
 
 using namespace std;
 using namespace std::chrono;
 
-// Atomic counter
-std::atomic<int> tileCounter;
 std::atomic<bool> cancelRender(false);
 
 static void writeRenderOutputs(const Camera& camera, const std::vector<PixelData>& buffer, const std::string& prefix) {
-    std::vector<unsigned char> pixels(IMAGE_WIDTH * IMAGE_HEIGHT * 4);
+    const RenderSettings& settings = camera.settings;
+    std::vector<unsigned char> pixels(settings.width * settings.height * 4);
 
-    if (RENDER_TYPE == RenderType::All) {
+    if (settings.renderType == RenderType::All) {
         for (RenderType type : { RenderType::Light, RenderType::Normals, RenderType::Depth, RenderType::BVH, RenderType::Samples }) {
             pixels = camera.getRenderOutput(buffer, type);
-            lodepng::encode(OUTPUT_DIR + prefix + RenderTypeMap.at(type) + ".png", pixels, IMAGE_WIDTH, IMAGE_HEIGHT);
+            lodepng::encode(settings.outputDir + prefix + RenderTypeMap.at(type) + ".png", pixels, settings.width, settings.height);
         }
     }
     else {
-        pixels = camera.getRenderOutput(buffer, RENDER_TYPE);
-        lodepng::encode(OUTPUT_DIR + prefix + RenderTypeMap.at(RENDER_TYPE) + ".png", pixels, IMAGE_WIDTH, IMAGE_HEIGHT);
+        pixels = camera.getRenderOutput(buffer, settings.renderType);
+        lodepng::encode(settings.outputDir + prefix + RenderTypeMap.at(settings.renderType) + ".png", pixels, settings.width, settings.height);
     }
 }
 
@@ -62,68 +67,323 @@ static void writeMetadata(const std::string& filepath, int renderDuration, const
 
 static void outputRenderSnapshot(const Camera& camera, const std::vector<PixelData>& pixelDataBuffer, std::chrono::steady_clock::time_point startTime, const std::string& settings, const std::string& bvhString) {
     using namespace std::chrono;
-    int renderDuration = duration_cast<seconds>(high_resolution_clock::now() - startTime).count();
+    int renderDuration = duration_cast<seconds>(steady_clock::now() - startTime).count();
     std::cout << "\nRender snapshot at " << renderDuration << " s." << std::endl;
 
-    std::filesystem::create_directory(OUTPUT_DIR + "snapshot");
+    std::filesystem::create_directory(camera.settings.outputDir + "snapshot");
     writeRenderOutputs(camera, pixelDataBuffer, "snapshot/render_");
-    writeMetadata(OUTPUT_DIR + "snapshot/metadata.txt", renderDuration, settings, bvhString, "Snapshot");
+    writeMetadata(camera.settings.outputDir + "snapshot/metadata.txt", renderDuration, settings, bvhString, "Snapshot");
 }
 
 static void outputFinalRender(const Camera& camera, std::vector<PixelData>& pixelDataBuffer, std::chrono::steady_clock::time_point startTime, const std::string& settings, const std::string& bvhString) {
     using namespace std::chrono;
-    int renderDuration = duration_cast<seconds>(high_resolution_clock::now() - startTime).count();
+    int renderDuration = duration_cast<seconds>(steady_clock::now() - startTime).count();
     std::cout << "\nCompleted render in " << renderDuration << " s.\nPassing though post processing..." << std::endl;
 
     // Post process (placeholder)
-    auto postStart = high_resolution_clock::now();
+    auto postStart = steady_clock::now();
     // ...
-    auto duration = duration_cast<seconds>(high_resolution_clock::now() - postStart).count();
+    auto duration = duration_cast<seconds>(steady_clock::now() - postStart).count();
     std::cout << "Completed post processing in " << duration << " s.\nWriting to file..." << std::endl;
 
-    auto writeStart = high_resolution_clock::now();
+    auto writeStart = steady_clock::now();
     writeRenderOutputs(camera, pixelDataBuffer, "render_");
-    writeMetadata(OUTPUT_DIR + "metadata.txt", renderDuration, settings, bvhString, "Completed");
+    writeMetadata(camera.settings.outputDir + "metadata.txt", renderDuration, settings, bvhString, "Completed");
 
-    int writeMs = duration_cast<milliseconds>(high_resolution_clock::now() - writeStart).count();
+    int writeMs = duration_cast<milliseconds>(steady_clock::now() - writeStart).count();
     std::cout << "Completed write in " << writeMs << " ms." << std::endl;
 }
 
 
 constexpr int TILE_SIZE = 16;
-void renderTile(Camera& camera, std::unique_ptr<BVHNode>& rootBVH, vector<PixelData>& pixelBuffer, int width, int height, int tilesX, int tilesY) {
-    while (!cancelRender) {
-        int index = tileCounter.fetch_add(1, std::memory_order_relaxed);
-        if (index >= tilesX * tilesY) {
-            break;
+
+// Passes over the frame, threads share them through the work stealing scheduler
+struct PassSchedule {
+    int width = 0;
+    int height = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    int maxPasses = 1;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    TileScheduler scheduler;
+    std::atomic<int> pass{ 0 }; // being dealt, earlier passes may still be finishing
+    std::atomic<int> completedWork{ 0 }; // tile passes done
+    std::atomic<int> finishedTiles{ 0 };
+    std::atomic<int> activeThreads{ 0 };
+    std::atomic<unsigned> readyThreads{ 0 }; // pinned threads done building their part of the frame
+    unsigned threadCount = 1;
+    std::chrono::steady_clock::time_point renderEnd; // set by the last thread out
+    std::unique_ptr<std::atomic<int>[]> tilePasses; // passes completed per tile
+    std::unique_ptr<bool[]> tileFinished;
+    std::unique_ptr<std::mutex[]> tileLocks; // held while a tile renders, so its pixels can be copied between passes
+    std::unique_ptr<RenderCounters[]> threadCounters; // each thread's counters, filled in as it ends
+    std::unique_ptr<TileTimeline> timeline; // when one was asked for
+
+    PassSchedule(int width, int height, int maxPasses, unsigned threads) : width(width), height(height),
+        tilesX((width + TILE_SIZE - 1) / TILE_SIZE), tilesY((height + TILE_SIZE - 1) / TILE_SIZE), maxPasses(maxPasses),
+        scheduler(tilesX, tilesY, threads, COARSE_TILES), threadCount(threads),
+        tilePasses(new std::atomic<int>[tilesX * tilesY]), tileFinished(new bool[tilesX * tilesY]), tileLocks(new std::mutex[tilesX * tilesY]),
+        threadCounters(new RenderCounters[threads]) {
+        for (int i = 0; i < tilesX * tilesY; ++i) {
+            tilePasses[i] = 0;
+            tileFinished[i] = false;
+        }
+    }
+
+    int totalTiles() const { return tilesX * tilesY; }
+
+    bool hasWork() const {
+        return pass < maxPasses && finishedTiles < totalTiles();
+    }
+
+    // Passes every tile has done, converged tiles count as done with all of them
+    int getPassesDone() const {
+        int done = maxPasses;
+        for (int i = 0; i < totalTiles(); ++i) {
+            if (!tileFinished[i]) done = std::min(done, tilePasses[i].load());
+        }
+        return done;
+    }
+
+    // Asked before each pass is dealt
+    bool startPass(int nextPass) {
+        if (cancelRender || std::chrono::steady_clock::now() >= deadline) return false;
+        pass = nextPass;
+        return hasWork();
+    }
+
+    // Continues from the slowest tile, tiles already past it skip the passes they have done.
+    // False, changing nothing, if a tile is past the last pass of this render
+    bool resume(const std::vector<Checkpoint::TileState>& tiles) {
+        for (const Checkpoint::TileState& tile : tiles) {
+            if (tile.passes < 0 || tile.passes > maxPasses) return false;
+        }
+
+        int slowest = maxPasses;
+        finishedTiles = 0;
+        completedWork = 0;
+        for (int i = 0; i < totalTiles(); ++i) {
+            tilePasses[i] = tiles[i].passes;
+            tileFinished[i] = tiles[i].finished;
+            if (tiles[i].finished) finishedTiles++;
+            slowest = std::min(slowest, tiles[i].passes);
+            completedWork += tiles[i].passes;
         }
+        pass = slowest;
+        return true;
+    }
 
-        // Calculate pixels in tile
-        int tileX = (index % tilesX) * TILE_SIZE;
-        int tileY = (index / tilesX) * TILE_SIZE;
+    // Builds the pixels of a range of tiles row by row, copied from resumed when there are any
+    void constructRange(FrameBuffer& pixels, const TileRange& range, const std::vector<PixelAccumulator>& resumed) const {
+        int x0 = range.x0 * TILE_SIZE, x1 = std::min(range.x1 * TILE_SIZE, width);
+        for (int y = range.y0 * TILE_SIZE; y < std::min(range.y1 * TILE_SIZE, height); ++y) {
+            size_t start = (size_t)y * width + x0, end = (size_t)y * width + x1;
+            pixels.construct(start, end, resumed.empty() ? nullptr : resumed.data() + start);
+        }
+    }
 
+    // Calls func(x, y) for the tile's pixels, row by row
+    template <typename Func>
+    void forTilePixels(int tile, Func&& func) const {
+        int tileX = (tile % tilesX) * TILE_SIZE;
+        int tileY = (tile / tilesX) * TILE_SIZE;
         for (int y = tileY; y < std::min(tileY + TILE_SIZE, height); ++y) {
             for (int x = tileX; x < std::min(tileX + TILE_SIZE, width); ++x) {
-                pixelBuffer[y * width + x] = camera.tracePixel(x, y, width, height, rootBVH.get());
+                func(x, y);
+            }
+        }
+    }
+};
+
+static bool isPixelFinished(const PixelAccumulator& pixel, const RenderSettings& settings) {
+    if (pixel.samples >= (int)settings.maxSamples) return true;
+    return pixel.samples >= (int)settings.minSamples && pixel.getRelativeError() < settings.noiseTarget;
+}
+
+// Tile by tile, so the copy never sees a tile halfway through a pass
+static std::vector<PixelData> resolvePixels(const FrameBuffer& accumulators, PassSchedule& schedule) {
+    std::vector<PixelData> pixels(accumulators.size());
+    for (int tile = 0; tile < schedule.totalTiles(); ++tile) {
+        std::lock_guard<std::mutex> lock(schedule.tileLocks[tile]);
+        schedule.forTilePixels(tile, [&](int x, int y) {
+            pixels[y * schedule.width + x] = accumulators[y * schedule.width + x].resolve();
+        });
+    }
+    return pixels;
+}
+
+static void writeCheckpoint(const std::string& path, const FrameBuffer& accumulators, PassSchedule& schedule, uint64_t renderHash) {
+    auto readTile = [&](int tile, std::vector<PixelAccumulator>& outPixels) {
+        std::lock_guard<std::mutex> lock(schedule.tileLocks[tile]);
+        schedule.forTilePixels(tile, [&](int x, int y) {
+            outPixels.push_back(accumulators[y * schedule.width + x]);
+        });
+        return Checkpoint::TileState{ schedule.tilePasses[tile].load(), schedule.tileFinished[tile] };
+    };
+    if (!Checkpoint::save(path, renderHash, schedule.width, schedule.height, TILE_SIZE, readTile))
+        cerr << "\nCould not write checkpoint '" << path << "'\n";
+}
+
+static std::string getRenderStats(const PassSchedule& schedule, unsigned threads, double renderSeconds) {
+    double total = 0, slowest = 0;
+    for (int i = 0; i < schedule.totalTiles(); ++i) {
+        total += schedule.scheduler.getTileSeconds(i);
+        slowest = std::max(slowest, schedule.scheduler.getTileSeconds(i));
+    }
+    double mean = total / schedule.totalTiles();
+
+    // Busy time against the wall clock shows how long threads sat idle
+    RenderCounters counters;
+    std::string threadLines;
+    for (unsigned t = 0; t < threads; ++t) {
+        const RenderCounters& thread = schedule.threadCounters[t];
+        counters.add(thread);
+        threadLines += "  Thread " + std::to_string(t) + ": " + std::to_string(thread.tiles) + " tiles, " + std::to_string(thread.tileSeconds) + " s, "
+            + std::to_string(thread.samples) + " samples, " + std::to_string(thread.getTotalRays()) + " rays\n";
+    }
+    double utilization = renderSeconds > 0 ? counters.tileSeconds / (threads * renderSeconds) : 1;
+
+    std::string stats =
+        "Scheduler Stats:\n"
+        "  Passes: " + std::to_string(schedule.getPassesDone()) + "/" + std::to_string(schedule.maxPasses) + "\n"
+        "  Tile cost: " + std::to_string(mean * 1000) + " ms mean, " + std::to_string(slowest * 1000) + " ms max (" + std::to_string(mean > 0 ? slowest / mean : 0) + "x)\n"
+        "  Steals: " + std::to_string(schedule.scheduler.getSteals()) + ", splits: " + std::to_string(schedule.scheduler.getSplits()) + "\n"
+        "  Thread utilization: " + std::to_string(utilization * 100) + "%\n";
+    if (!RENDER_STATS) return stats;
+
+    // Deepest bounce reached first, so the list ends there
+    int depths = RenderCounters::DEPTHS;
+    while (depths > 1 && counters.raysByDepth[depths - 1] == 0) depths--;
+    std::string byDepth;
+    for (int d = 0; d < depths; ++d) {
+        byDepth += (d > 0 ? ", " : "") + std::to_string(counters.raysByDepth[d]);
+    }
+    if (depths == RenderCounters::DEPTHS) byDepth += " (and deeper)";
+
+    double rays = (double)std::max<uint64_t>(counters.getTotalRays(), 1);
+    return stats + "\n"
+        "Render Stats:\n"
+        "  Samples: " + std::to_string(counters.samples) + " (" + std::to_string(counters.samples / (double)(schedule.width * schedule.height)) + " per pixel)\n"
+        "  Rays: " + std::to_string(counters.getTotalRays()) + " (" + std::to_string(counters.getPrimaryRays()) + " primary, " + std::to_string(counters.shadowRays) + " shadow), "
+            + std::to_string(renderSeconds > 0 ? counters.getTotalRays() / renderSeconds / 1e6 : 0) + " M/s\n"
+        "  Rays by depth: " + byDepth + "\n"
+        "  Per ray: " + std::to_string(counters.nodeTests / rays) + " nodes, " + std::to_string(counters.boxTests / rays) + " boxes, "
+            + std::to_string(counters.primitiveTests / rays) + " primitives\n"
+        "  Roulette terminations: " + std::to_string(counters.rouletteTerminations) + "\n"
+        + threadLines;
+}
+
+void renderTile(Camera& camera, const Accelerator& bvh, const EmitterList& emitters, FrameBuffer& pixelBuffer, const vector<PixelAccumulator>& resumedPixels, PassSchedule& schedule, unsigned thread) {
+    int width = schedule.width;
+    int height = schedule.height;
+    const RenderSettings& settings = camera.settings;
+    if (settings.pinThreads) {
+        Threading::pinCurrentThread(thread);
+
+        // Build the tiles this thread is dealt first so their pages are local to its core, then wait for the rest.
+        // Nothing is taken before every thread is ready, so the dealt ranges cover the frame
+        for (const TileRange& range : schedule.scheduler.getDealt(thread)) {
+            schedule.constructRange(pixelBuffer, range, resumedPixels);
+        }
+        schedule.readyThreads++;
+        while (schedule.readyThreads < schedule.threadCount) {
+            std::this_thread::yield();
+        }
+    }
+
+    int index, pass;
+    while (schedule.scheduler.next(thread, index, pass)) {
+        if (cancelRender || std::chrono::steady_clock::now() >= schedule.deadline) {
+            schedule.scheduler.stop();
+            break;
+        }
+
+        // Another thread may still be on this tile's previous pass, but only for a moment
+        if (schedule.tilePasses[index] < pass) {
+            auto waitStart = std::chrono::steady_clock::now();
+            while (schedule.tilePasses[index] < pass && !schedule.scheduler.isStopped()) {
+                std::this_thread::yield();
             }
+            if (schedule.timeline) schedule.timeline->record(thread, "wait", index, pass, 0, waitStart, std::chrono::steady_clock::now());
+        }
+        if (schedule.scheduler.isStopped()) break;
+
+        // Calculate pixels in tile, unless resumed past this pass
+        std::lock_guard<std::mutex> lock(schedule.tileLocks[index]);
+        if (schedule.tilePasses[index] > pass) continue;
+        auto tileStart = std::chrono::steady_clock::now();
+        uint64_t startSamples = RenderStats::counters.samples;
+        if (!schedule.tileFinished[index]) {
+            bool finished = true;
+            schedule.forTilePixels(index, [&](int x, int y) {
+                PixelAccumulator& pixel = pixelBuffer[y * width + x];
+                if (!settings.progressive) {
+                    camera.tracePixel(x, y, width, height, bvh, emitters, pixel);
+                    return;
+                }
+
+                if (isPixelFinished(pixel, settings)) return;
+                int count = std::min<int>(settings.samplesPerPass, settings.maxSamples - pixel.samples);
+                camera.samplePixel(x, y, width, height, bvh, emitters, pixel, count);
+                finished &= isPixelFinished(pixel, settings);
+            });
+
+            if (finished) {
+                schedule.tileFinished[index] = true;
+                schedule.finishedTiles++;
+            }
+        }
+        auto tileEnd = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(tileEnd - tileStart).count();
+        schedule.scheduler.recordTile(index, seconds);
+        RenderStats::counters.tiles++;
+        RenderStats::counters.tileSeconds += seconds;
+        if (schedule.timeline) {
+            schedule.timeline->record(thread, "tile", index, pass, (int)(RenderStats::counters.samples - startSamples), tileStart, tileEnd);
         }
+        schedule.tilePasses[index] = pass + 1;
+        schedule.completedWork++;
+    }
+
+    schedule.threadCounters[thread] = RenderStats::counters;
+    if (--schedule.activeThreads == 0) {
+        schedule.renderEnd = std::chrono::steady_clock::now();
     }
 }
 
-int main() {
-    auto startTime = high_resolution_clock::now();
-	std::filesystem::create_directory(OUTPUT_DIR);
+int main(int argc, char** argv) {
+    auto startTime = steady_clock::now();
+
+    // Settings from the command line, defaulting to Constants.h
+    RenderSettings renderSettings;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            if (std::string(argv[i]) == "--help" || std::string(argv[i]) == "-h") {
+                cout << RenderSettings::getUsage();
+                return 0;
+            }
+        }
+        renderSettings = RenderSettings::fromArguments(argc, argv);
+    }
+    catch (const std::runtime_error& error) {
+        cerr << error.what() << "\n\n" << RenderSettings::getUsage();
+        return 1;
+    }
+	std::filesystem::create_directories(renderSettings.outputDir);
+
+    // Ctrl+C stops after the current tiles and keeps a checkpoint to continue from
+    std::signal(SIGINT, [](int) { cancelRender = true; });
 
     // Print
-    const std::string settings = Utilities::getMetadata();
+    const std::string settings = Utilities::getMetadata(renderSettings);
     cout << settings << endl;
 
     // Object read
-    SceneSetup setup = TraceParser::readTrcFile(SCENE);
+    SceneSetup setup = TraceParser::readTrcFile(renderSettings.scene);
     cout << "Creating BVH...\n";
 
     // Camera
-    Camera camera(setup.cameraFrom, setup.cameraTo, Vector3d(0.0, 1.0, 0.0), setup.fov, ASPECT);
+    Camera camera(setup.cameraFrom, setup.cameraTo, Vector3d(0.0, 1.0, 0.0), setup.fov, (float)renderSettings.width / renderSettings.height, renderSettings);
 
     // Hittables
     BVHNode::scene = std::move(setup.hittables);
@@ -134,51 +394,148 @@ int main() {
     for (auto& hittable : BVHNode::scene) {
         rawScene.push_back(hittable.get());
     }
-    unique_ptr<BVHNode> rootBVH = make_unique<BVHNode>(rawScene, 0, rawScene.size());
+    BVHBuildSettings buildSettings;
+    buildSettings.threads = renderSettings.getThreadCount();
+    BVHStats stats;
+    auto buildStart = steady_clock::now();
+
+    // Reuse the cached BVH when the scene hasn't changed
+    unique_ptr<LinearBVH> linearBVH;
+    uint64_t sceneHash = BVHCache::hashScene(rawScene, buildSettings);
+    std::string cachePath = BVHCache::getCachePath(sceneHash);
+    if (BVH_CACHE) {
+        linearBVH = BVHCache::load(cachePath, sceneHash, BVHNode::scene, buildSettings);
+        stats.cached = linearBVH != nullptr;
+    }
+
+    if (!linearBVH) {
+        unique_ptr<BVHNode> rootBVH = BVHNode::build(rawScene, buildSettings);
+
+        // Flatten for traversal, the pointer tree is only needed to build
+        linearBVH = make_unique<LinearBVH>(rootBVH.get(), rawScene, buildSettings);
+        rootBVH.reset();
+
+        if (BVH_CACHE) {
+            std::filesystem::create_directory(BVH_CACHE_DIR);
+            if (!BVHCache::save(cachePath, sceneHash, *linearBVH, BVHNode::scene))
+                cerr << "Could not write BVH cache '" << cachePath << "'\n";
+        }
+    }
 
     // Debug
-    BVHStats stats;
-    BVHNode::getNodeDebugInfo(rootBVH.get(), 1, stats);
+    stats.buildMs = duration_cast<milliseconds>(steady_clock::now() - buildStart).count();
+    linearBVH->getNodeDebugInfo(stats);
+    stats.sahCost = linearBVH->getSAHCost(buildSettings);
+    stats.totalReferences = (int)linearBVH->primitives.size();
 
     const std::string bvhString = 
     "BVH Stats:\n"
+    "  Build method: " + BVHBuildMethodMap.at(buildSettings.method) + (stats.cached ? " (cached)" : "") + "\n"
+    "  Layout: " + BVHLayoutMap.at(BVH_LAYOUT) + "\n"
     "  Total nodes: " + std::to_string(stats.totalNodes) + "\n"
     "  Max depth: " + std::to_string(stats.maxDepth) + "\n"
-    "  Total leaf nodes: " + std::to_string(stats.totalLeafNodes) + "\n";
+    "  Total leaf nodes: " + std::to_string(stats.totalLeafNodes) + "\n"
+    "  Max leaf size: " + std::to_string(stats.maxLeafSize) + "\n"
+    "  Primitive references: " + std::to_string(stats.totalReferences) + " (" + std::to_string(BVHNode::scene.size()) + " objects)\n"
+    "  SAH cost: " + std::to_string(stats.sahCost) + "\n"
+    "  Build time: " + std::to_string(stats.buildMs) + " ms\n";
     cout << bvhString << endl;
 
-    // Output 
-    vector<PixelData> pixelDataBuffer(IMAGE_WIDTH * IMAGE_HEIGHT);
+    // Collapse into wide nodes
+    unique_ptr<Accelerator> bvh;
+    if (BVH_LAYOUT == BVHLayout::Wide4)
+        bvh = make_unique<BVH4>(*linearBVH);
+    else if (BVH_LAYOUT == BVHLayout::Wide8)
+        bvh = make_unique<BVH8>(*linearBVH);
+    else
+        bvh = std::move(linearBVH);
+
+    // Emitters for direct lighting
+    EmitterList emitters(BVHNode::scene, renderSettings.lightSampling);
+    cout << "Emitters: " << emitters.emitters.size() << " (" << LightSamplingMap.at(renderSettings.lightSampling) << " sampling)\n" << endl;
+
+    // Output, kept across passes
+    const int width = renderSettings.width, height = renderSettings.height;
+    const bool progressive = renderSettings.progressive;
+    const unsigned threadCount = renderSettings.getThreadCount();
+    FrameBuffer pixelBuffer(width, height);
+    int maxPasses = progressive ? (renderSettings.maxSamples + renderSettings.samplesPerPass - 1) / renderSettings.samplesPerPass : 1;
+    PassSchedule schedule(width, height, maxPasses, threadCount);
+    if (progressive && renderSettings.timeBudget > 0) {
+        schedule.deadline = startTime + seconds(renderSettings.timeBudget);
+    }
 
-    // Calculate number of tiles
-    int tilesX = (IMAGE_WIDTH + TILE_SIZE - 1) / TILE_SIZE;
-    int tilesY = (IMAGE_HEIGHT + TILE_SIZE - 1) / TILE_SIZE;
+    // Continue an interrupted render
+    const std::string checkpointPath = renderSettings.getCheckpointPath();
+    uint64_t renderHash = Checkpoint::hashRender(renderSettings, sceneHash, setup.files, TILE_SIZE);
+    vector<PixelAccumulator> resumedPixels;
+    vector<Checkpoint::TileState> resumedTiles;
+    if (renderSettings.resume && Checkpoint::load(checkpointPath, renderHash, width, height, TILE_SIZE, resumedPixels, resumedTiles)) {
+        if (schedule.resume(resumedTiles)) {
+            cout << "Resuming from checkpoint at pass " << schedule.pass + 1 << "\n" << endl;
+        }
+        else {
+            cerr << "Checkpoint has more passes than this render, starting over\n";
+            resumedPixels.clear();
+        }
+    }
 
     // Ray tracing
-    // Launch threads equal to logical cores
-    tileCounter = 0;
+    // Launch a thread per core. Pinned threads build the tiles they are dealt first, floating ones have no node to build for
+    auto renderStart = steady_clock::now();
+    schedule.renderEnd = renderStart;
+    if (!renderSettings.timelinePath.empty()) {
+        schedule.timeline = make_unique<TileTimeline>(threadCount, renderStart);
+    }
     std::vector<std::thread> threads;
-    for (int t = 0; t < THREADS; ++t) {
-        threads.emplace_back(renderTile, std::ref(camera), std::ref(rootBVH), std::ref(pixelDataBuffer), IMAGE_WIDTH, IMAGE_HEIGHT, tilesX, tilesY);
+    bool threadsBuild = schedule.hasWork() && renderSettings.pinThreads;
+    if (!threadsBuild) {
+        pixelBuffer.construct(0, pixelBuffer.size(), resumedPixels.empty() ? nullptr : resumedPixels.data());
+    }
+    if (schedule.hasWork()) {
+        schedule.scheduler.start(schedule.pass, [&](int pass) { return schedule.startPass(pass); });
+        schedule.activeThreads = threadCount;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            threads.emplace_back(renderTile, std::ref(camera), std::cref(*bvh), std::cref(emitters), std::ref(pixelBuffer), std::cref(resumedPixels), std::ref(schedule), t);
+        }
+        while (threadsBuild && schedule.readyThreads < threadCount) {
+            std::this_thread::yield();
+        }
     }
 
     // Progress
-	int totalTiles = tilesX * tilesY;
-    auto lastSnapshot = high_resolution_clock::now();
+    int totalWork = maxPasses * schedule.totalTiles();
+    auto lastSnapshot = steady_clock::now();
+    auto lastCheckpoint = steady_clock::now();
     auto lastPercent = 0.0f;
-    while (tileCounter < totalTiles && !cancelRender) {
+    while (schedule.activeThreads > 0 && !cancelRender) {
         // Progress
-        int done = tileCounter.load(std::memory_order_relaxed);
-        float percent = (done / (float)(totalTiles)) * 100.0f;
-        cout << "\rRendering: " << std::round(percent) << "% (" << done << "/" << totalTiles << ")" << std::flush;
+        int done = std::min(schedule.completedWork.load(), totalWork);
+        float percent = (done / (float)(totalWork)) * 100.0f;
+        if (progressive && renderSettings.timeBudget > 0) {
+            // Usually stops on time before the last pass
+            float elapsed = duration_cast<milliseconds>(steady_clock::now() - startTime).count() / 1000.0f;
+            percent = std::min(std::max(percent, elapsed / renderSettings.timeBudget * 100.0f), 100.0f);
+        }
+        cout << "\rRendering: " << std::round(percent) << "% (" << done << "/" << totalWork << ")";
+        if (progressive) {
+            cout << " pass " << std::min(schedule.pass + 1, maxPasses) << "/" << maxPasses << ", " << schedule.finishedTiles << " tiles converged";
+        }
+        cout << std::flush;
         
         // Snapshot every so often
-        if (high_resolution_clock::now() - lastSnapshot >= minutes(20) || percent - lastPercent >= 20) {
-            lastSnapshot = high_resolution_clock::now();
+        if (steady_clock::now() - lastSnapshot >= minutes(20) || percent - lastPercent >= 20) {
+            lastSnapshot = steady_clock::now();
 			lastPercent = percent;
-			outputRenderSnapshot(camera, pixelDataBuffer, startTime, settings, bvhString);
+			outputRenderSnapshot(camera, resolvePixels(pixelBuffer, schedule), startTime, settings, bvhString);
 		}
 
+        // Checkpoint, render threads only wait while their tile is copied
+        if (renderSettings.checkpointInterval > 0 && steady_clock::now() - lastCheckpoint >= seconds(renderSettings.checkpointInterval)) {
+            lastCheckpoint = steady_clock::now();
+            writeCheckpoint(checkpointPath, pixelBuffer, schedule, renderHash);
+        }
+
         // Wait
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
     }
@@ -187,9 +544,32 @@ int main() {
     for (auto& t : threads) {
         t.join();
     }
+    double renderSeconds = duration<double>(schedule.renderEnd - renderStart).count();
+    const std::string renderStats = getRenderStats(schedule, threadCount, renderSeconds);
+    cout << "\n" << renderStats;
+    if (schedule.timeline && !schedule.timeline->write(renderSettings.timelinePath)) {
+        cerr << "Could not write timeline '" << renderSettings.timelinePath << "'\n";
+    }
+
+    // Keep the checkpoint of an unfinished render so it can be continued, drop it once complete
+    bool complete = schedule.getPassesDone() == maxPasses;
+    if (progressive && steady_clock::now() >= schedule.deadline) {
+        cout << "\nTime budget reached";
+    }
+    if (cancelRender) {
+        cout << "\nRender interrupted";
+    }
+    if (!complete && renderSettings.checkpointInterval > 0) {
+        writeCheckpoint(checkpointPath, pixelBuffer, schedule, renderHash);
+    }
+    else if (complete) {
+        std::error_code error;
+        std::filesystem::remove(checkpointPath, error);
+    }
 
     // Output
-	outputFinalRender(camera, pixelDataBuffer, startTime, settings, bvhString);
+    vector<PixelData> pixelDataBuffer = resolvePixels(pixelBuffer, schedule);
+	outputFinalRender(camera, pixelDataBuffer, startTime, settings, bvhString + "\n" + renderStats);
 
     return 0;
 }
\ No newline at end of file
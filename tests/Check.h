@@ -0,0 +1,13 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+// Failed checks are printed and counted, each test returns the count from main so ctest sees it
+
+inline int failures = 0;
+
+inline void check(bool condition, const std::string& what) {
+    if (condition) return;
+    std::cerr << "FAILED: " << what << "\n";
+    failures++;
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "Checkpoint.h"
+#include "Random.h"
+
+// Saves a checkpoint, loads it back and checks the pixels and tile progress survive, and that stale or short files are refused
+
+// Edges narrower than a tile exercise the partial tiles
+static constexpr int WIDTH = 37;
+static constexpr int HEIGHT = 21;
+static constexpr int TILE = 16;
+static constexpr int TILES_X = (WIDTH + TILE - 1) / TILE;
+static constexpr int TILES_Y = (HEIGHT + TILE - 1) / TILE;
+
+static std::vector<PixelAccumulator> makePixels(PCG32& rng) {
+    std::vector<PixelAccumulator> pixels(WIDTH * HEIGHT);
+    for (PixelAccumulator& pixel : pixels) {
+        pixel.colorSum = Color(rng.nextFloat(), rng.nextFloat(), rng.nextFloat());
+        pixel.colorSumSq = Color(rng.nextFloat(), rng.nextFloat(), rng.nextFloat());
+        pixel.depthSum = rng.nextFloat() * 100;
+        pixel.normalSum = Vector3d(rng.nextFloat(), rng.nextFloat(), rng.nextFloat());
+        pixel.checksSum = rng.nextUint();
+        pixel.samples = rng.nextUint() % 1024;
+    }
+    return pixels;
+}
+
+static std::vector<Checkpoint::TileState> makeTiles(PCG32& rng) {
+    std::vector<Checkpoint::TileState> tiles(TILES_X * TILES_Y);
+    for (Checkpoint::TileState& tile : tiles) {
+        tile.passes = rng.nextUint() % 16;
+        tile.finished = rng.nextUint() % 2 == 0;
+    }
+    return tiles;
+}
+
+static bool save(const std::string& path, uint64_t hash, const std::vector<PixelAccumulator>& pixels, const std::vector<Checkpoint::TileState>& tiles) {
+    return Checkpoint::save(path, hash, WIDTH, HEIGHT, TILE, [&](int tile, std::vector<PixelAccumulator>& outPixels) {
+        int tileX = (tile % TILES_X) * TILE;
+        int tileY = (tile / TILES_X) * TILE;
+        for (int y = tileY; y < std::min(tileY + TILE, HEIGHT); ++y) {
+            for (int x = tileX; x < std::min(tileX + TILE, WIDTH); ++x) outPixels.push_back(pixels[y * WIDTH + x]);
+        }
+        return tiles[tile];
+    });
+}
+
+static bool samePixel(const PixelAccumulator& a, const PixelAccumulator& b) {
+    return a.colorSum.r == b.colorSum.r && a.colorSum.g == b.colorSum.g && a.colorSum.b == b.colorSum.b
+        && a.colorSumSq.r == b.colorSumSq.r && a.colorSumSq.g == b.colorSumSq.g && a.colorSumSq.b == b.colorSumSq.b
+        && a.depthSum == b.depthSum && a.normalSum.x == b.normalSum.x && a.normalSum.y == b.normalSum.y && a.normalSum.z == b.normalSum.z
+        && a.checksSum == b.checksSum && a.samples == b.samples;
+}
+
+static void testRoundTrip(const std::string& path) {
+    PCG32 rng(1);
+    std::vector<PixelAccumulator> pixels = makePixels(rng);
+    std::vector<Checkpoint::TileState> tiles = makeTiles(rng);
+    check(save(path, 42, pixels, tiles), "checkpoint saves");
+
+    std::vector<PixelAccumulator> loadedPixels;
+    std::vector<Checkpoint::TileState> loadedTiles;
+    check(Checkpoint::load(path, 42, WIDTH, HEIGHT, TILE, loadedPixels, loadedTiles), "checkpoint loads");
+    check(loadedPixels.size() == pixels.size() && loadedTiles.size() == tiles.size(), "loaded checkpoint covers the frame");
+    if (loadedPixels.size() != pixels.size() || loadedTiles.size() != tiles.size()) return;
+
+    bool pixelsMatch = true;
+    for (size_t i = 0; i < pixels.size(); ++i) pixelsMatch &= samePixel(pixels[i], loadedPixels[i]);
+    check(pixelsMatch, "loaded pixels match the saved pixels");
+
+    bool tilesMatch = true;
+    for (size_t i = 0; i < tiles.size(); ++i) tilesMatch &= tiles[i].passes == loadedTiles[i].passes && tiles[i].finished == loadedTiles[i].finished;
+    check(tilesMatch, "loaded tile progress matches the saved progress");
+}
+
+static void testRefused(const std::string& path) {
+    PCG32 rng(2);
+    check(save(path, 42, makePixels(rng), makeTiles(rng)), "checkpoint saves");
+
+    // Refused loads leave the outputs alone
+    std::vector<PixelAccumulator> pixels(1);
+    std::vector<Checkpoint::TileState> tiles(1);
+    check(!Checkpoint::load(path, 43, WIDTH, HEIGHT, TILE, pixels, tiles), "another render's hash is refused");
+    check(!Checkpoint::load(path, 42, WIDTH + 1, HEIGHT, TILE, pixels, tiles), "another size is refused");
+    check(!Checkpoint::load(path, 42, WIDTH, HEIGHT, TILE * 2, pixels, tiles), "another tile size is refused");
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    check(!Checkpoint::load(path, 42, WIDTH, HEIGHT, TILE, pixels, tiles), "a short file is refused");
+    check(pixels.size() == 1 && tiles.size() == 1, "refused loads keep the outputs");
+}
+
+static void writeFile(const std::filesystem::path& path, const std::string& contents) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+}
+
+// Every setting that changes how far a pass gets must change the hash
+static void testHash() {
+    RenderSettings settings;
+    std::vector<std::string> files;
+    uint64_t base = Checkpoint::hashRender(settings, 7, files, TILE);
+    check(Checkpoint::hashRender(settings, 7, files, TILE) == base, "the hash is stable");
+    check(Checkpoint::hashRender(settings, 8, files, TILE) != base, "the scene changes the hash");
+
+    RenderSettings changed = settings;
+    changed.samplesPerPass++;
+    check(Checkpoint::hashRender(changed, 7, files, TILE) != base, "samples per pass change the hash");
+    changed = settings;
+    changed.minSamples++;
+    check(Checkpoint::hashRender(changed, 7, files, TILE) != base, "minimum samples change the hash");
+    changed = settings;
+    changed.maxSamples++;
+    check(Checkpoint::hashRender(changed, 7, files, TILE) != base, "maximum samples change the hash");
+    changed = settings;
+    changed.noiseTarget += .01f;
+    check(Checkpoint::hashRender(changed, 7, files, TILE) != base, "the noise target changes the hash");
+    changed = settings;
+    changed.sampleThreshold += .01f;
+    check(Checkpoint::hashRender(changed, 7, files, TILE) != base, "the sample threshold changes the hash");
+}
+
+// Materials read in from another file change the render without changing the scene file or any object
+static void testIncludedFiles() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::filesystem::path scene = directory / "CheckpointTestScene.trc", materials = directory / "CheckpointTestMaterials.trc";
+    writeFile(scene, "read\n trc: " + materials.string() + "\n");
+    writeFile(materials, "materials\n red: 1,0,0 0,0,0 0 0 1\n");
+
+    RenderSettings settings;
+    std::vector<std::string> files = { scene.string(), materials.string() };
+    uint64_t base = Checkpoint::hashRender(settings, 7, files, TILE);
+    check(Checkpoint::hashRender(settings, 7, { scene.string() }, TILE) != base, "an included file changes the hash");
+
+    writeFile(materials, "materials\n red: 1,0,0 5,5,5 0 0 1\n");
+    check(Checkpoint::hashRender(settings, 7, files, TILE) != base, "editing an included file changes the hash");
+
+    std::filesystem::remove(scene);
+    std::filesystem::remove(materials);
+}
+
+int main() {
+    std::string path = (std::filesystem::temp_directory_path() / "CheckpointTest.ckpt").string();
+    testRoundTrip(path);
+    testRefused(path);
+    testHash();
+    testIncludedFiles();
+    std::filesystem::remove(path);
+    return failures;
+}
\ No newline at end of file
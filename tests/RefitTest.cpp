@@ -0,0 +1,150 @@
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BVHNode.h"
+#include "Check.h"
+#include "Instance.h"
+#include "LinearBVH.h"
+#include "Mesh.h"
+#include "Random.h"
+#include "Triangle.h"
+
+// Moves primitives under built BVHs and checks the refit trees still bound them and find the same hits
+
+static bool contains(const AABB& outer, const AABB& inner) {
+    return outer.lower.x <= inner.lower.x && outer.lower.y <= inner.lower.y && outer.lower.z <= inner.lower.z
+        && outer.upper.x >= inner.upper.x && outer.upper.y >= inner.upper.y && outer.upper.z >= inner.upper.z;
+}
+
+// Every node bounds its primitives, or both its children
+static bool boundsHold(const LinearBVH& bvh) {
+    for (size_t i = 0; i < bvh.nodeCount; ++i) {
+        const LinearBVHNode& node = bvh.nodes[i];
+        if (node.count == 0) {
+            if (!contains(node.bounds, bvh.nodes[i + 1].bounds) || !contains(node.bounds, bvh.nodes[node.offset].bounds)) return false;
+            continue;
+        }
+        for (int p = node.offset; p < node.offset + node.count; ++p) {
+            if (!contains(node.bounds, bvh.primitives[p]->getBoundingBox())) return false;
+        }
+    }
+    return true;
+}
+
+static Vector3 randomPoint(PCG32& rng, float extent) {
+    return Vector3((rng.nextFloat() * 2 - 1) * extent, (rng.nextFloat() * 2 - 1) * extent, (rng.nextFloat() * 2 - 1) * extent);
+}
+
+static std::vector<std::unique_ptr<Hittable>> makeTriangles(PCG32& rng, int count, float extent) {
+    auto material = std::make_shared<Material>(Color(.8f), Color(), 0.0f, 0.0f, 1.0f);
+    std::vector<std::unique_ptr<Hittable>> triangles;
+    for (int i = 0; i < count; ++i) {
+        Vector3 center = randomPoint(rng, extent);
+        triangles.push_back(std::make_unique<Triangle>(center + randomPoint(rng, .3f), center + randomPoint(rng, .3f), center + randomPoint(rng, .3f), material));
+    }
+    return triangles;
+}
+
+// Translation keeps the normal
+static void moveTriangle(Hittable* object, const Vector3& by) {
+    Triangle* triangle = static_cast<Triangle*>(object);
+    triangle->v0 = triangle->v0 + by;
+    triangle->v1 = triangle->v1 + by;
+    triangle->v2 = triangle->v2 + by;
+}
+
+static std::vector<Hittable*> getRaw(const std::vector<std::unique_ptr<Hittable>>& objects) {
+    std::vector<Hittable*> raw;
+    for (const auto& object : objects) raw.push_back(object.get());
+    return raw;
+}
+
+static std::unique_ptr<LinearBVH> buildBVH(const std::vector<Hittable*>& objects, const BVHBuildSettings& settings) {
+    std::vector<Hittable*> order = objects;
+    std::unique_ptr<BVHNode> root = BVHNode::build(order, settings);
+    return std::make_unique<LinearBVH>(root.get(), order, settings);
+}
+
+// The BVH should find exactly the closest hit of testing every object
+static int countMismatches(const Accelerator& bvh, const std::vector<Hittable*>& objects, PCG32& rng, float extent) {
+    int mismatches = 0;
+    for (int i = 0; i < 500; ++i) {
+        Vector3d origin = Vector3d(randomPoint(rng, extent * 2));
+        Ray ray(origin, (Vector3d(randomPoint(rng, extent)) - origin).normalized());
+
+        HitRecord expected, found;
+        int checks = 0;
+        for (Hittable* object : objects) object->intersect(ray, expected, checks);
+        bvh.intersect(ray, found, checks);
+        if (found.t != expected.t || found.shape != expected.shape) mismatches++;
+    }
+    return mismatches;
+}
+
+static void testRefit(const BVHBuildSettings& settings) {
+    PCG32 rng(1);
+    std::vector<std::unique_ptr<Hittable>> triangles = makeTriangles(rng, 2000, 5);
+    std::vector<Hittable*> raw = getRaw(triangles);
+    std::unique_ptr<LinearBVH> bvh = buildBVH(raw, settings);
+
+    for (size_t i = 0; i < raw.size(); i += 2) moveTriangle(raw[i], randomPoint(rng, 2));
+    check(!boundsHold(*bvh), "moved triangles should leave the built bounds");
+    bvh->refit();
+    check(boundsHold(*bvh), "refit bounds contain the moved triangles");
+    check(countMismatches(*bvh, raw, rng, 5) == 0, "refit BVH finds the closest hits");
+}
+
+static void testRebuildBaseline(const BVHBuildSettings& settings) {
+    PCG32 rng(2);
+    std::vector<std::unique_ptr<Hittable>> triangles = makeTriangles(rng, 2000, 5);
+    std::vector<Hittable*> raw = getRaw(triangles);
+    std::unique_ptr<LinearBVH> bvh = buildBVH(raw, settings);
+    float builtCost = bvh->getSAHCost(settings);
+
+    // A refit first must not become the baseline, scattering every triangle is well past the threshold
+    for (Hittable* triangle : raw) moveTriangle(triangle, randomPoint(rng, 20));
+    bvh->refit();
+    check(bvh->getSAHCost(settings) > builtCost * REFIT_REBUILD_THRESHOLD, "scattered triangles degrade the refit tree");
+    check(bvh->refitOrRebuild(settings), "refitOrRebuild rebuilds against the cost when built");
+    check(boundsHold(*bvh), "rebuilt bounds contain the triangles");
+    check(countMismatches(*bvh, raw, rng, 20) == 0, "rebuilt BVH finds the closest hits");
+
+    // Small moves stay within the threshold
+    for (Hittable* triangle : raw) moveTriangle(triangle, randomPoint(rng, .01f));
+    check(!bvh->refitOrRebuild(settings), "small moves only refit");
+    check(boundsHold(*bvh), "refit bounds contain the nudged triangles");
+}
+
+static void testSceneRefit(const BVHBuildSettings& settings) {
+    PCG32 rng(3);
+    auto mesh = std::make_shared<Mesh>(makeTriangles(rng, 300, 1), settings);
+    std::unordered_map<std::string, std::shared_ptr<Mesh>> meshes = { { "mesh", mesh } };
+
+    auto material = std::make_shared<Material>(Color(.8f), Color(), 0.0f, 0.0f, 1.0f);
+    std::vector<std::unique_ptr<Hittable>> instances;
+    instances.push_back(std::make_unique<Instance>(mesh, 1.0f, Vector3(-4.0f, 0.0f, 0.0f), Vector3(), material));
+    instances.push_back(std::make_unique<Instance>(mesh, 2.0f, Vector3(0.0f, 0.0f, 0.0f), Vector3(30.0f, 45.0f, 0.0f), material));
+    instances.push_back(std::make_unique<Instance>(mesh, .5f, Vector3(4.0f, 1.0f, 0.0f), Vector3(0.0f, 0.0f, 90.0f), material));
+    std::vector<Hittable*> raw = getRaw(instances);
+    std::unique_ptr<LinearBVH> scene = buildBVH(raw, settings);
+
+    // Moving the mesh moves every instance of it
+    for (const auto& triangle : mesh->triangles) moveTriangle(triangle.get(), Vector3(0.0f, 3.0f, 0.0f));
+    Mesh::refitScene(meshes, *scene, settings);
+    check(boundsHold(*mesh->bvh), "refit mesh bounds contain its moved triangles");
+    check(boundsHold(*scene), "refit scene bounds contain the moved instances");
+    check(countMismatches(*scene, raw, rng, 6) == 0, "refit scene BVH finds the closest instance hits");
+}
+
+int main() {
+    for (BVHBuildMethod method : { BVHBuildMethod::SAH, BVHBuildMethod::SBVH }) {
+        BVHBuildSettings settings;
+        settings.method = method;
+        testRefit(settings);
+        testRebuildBaseline(settings);
+        testSceneRefit(settings);
+    }
+    return failures;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "Random.h"
+#include "TileScheduler.h"
+
+// Renders with many more threads than tiles per thread, each tile sleeping a random moment, the way the renderer
+// waits on a tile's previous pass, and checks every tile gets every pass exactly once and in order
+
+struct Harness {
+    int tilesX, tilesY, passes;
+    TileScheduler scheduler;
+    std::unique_ptr<std::atomic<int>[]> tilePasses; // passes completed per tile
+    std::unique_ptr<std::atomic<int>[]> renders; // times each tile and pass was rendered
+    std::atomic<int> outOfOrder{ 0 };
+
+    Harness(int tilesX, int tilesY, int passes, unsigned threads, int coarseSize) : tilesX(tilesX), tilesY(tilesY), passes(passes),
+        scheduler(tilesX, tilesY, threads, coarseSize), tilePasses(new std::atomic<int>[tilesX * tilesY]), renders(new std::atomic<int>[tilesX * tilesY * passes]) {
+        for (int i = 0; i < tilesX * tilesY; ++i) tilePasses[i] = 0;
+        for (int i = 0; i < tilesX * tilesY * passes; ++i) renders[i] = 0;
+    }
+
+    void renderThread(unsigned thread) {
+        PCG32 rng(thread + 1);
+        int tile, pass;
+        while (scheduler.next(thread, tile, pass)) {
+            while (tilePasses[tile] < pass && !scheduler.isStopped()) std::this_thread::yield();
+            if (scheduler.isStopped()) break;
+
+            if (tilePasses[tile] != pass) outOfOrder++;
+            renders[tile * passes + pass]++;
+            auto start = std::chrono::steady_clock::now();
+            std::this_thread::sleep_for(std::chrono::microseconds(rng.nextUint() % 200));
+            scheduler.recordTile(tile, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            tilePasses[tile] = pass + 1;
+        }
+    }
+
+    void run(unsigned threadCount) {
+        scheduler.start(0, [&](int pass) { return pass < passes; });
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < threadCount; ++t) threads.emplace_back(&Harness::renderThread, this, t);
+        for (auto& thread : threads) thread.join();
+    }
+};
+
+static void testEveryPass(int tilesX, int tilesY, int passes, unsigned threads, int coarseSize) {
+    std::string name = std::to_string(tilesX) + "x" + std::to_string(tilesY) + " tiles, " + std::to_string(passes) + " passes, "
+        + std::to_string(threads) + " threads";
+    for (int run = 0; run < 8; ++run) {
+        Harness harness(tilesX, tilesY, passes, threads, coarseSize);
+        harness.run(threads);
+
+        int missing = 0, repeated = 0;
+        for (int i = 0; i < tilesX * tilesY * passes; ++i) {
+            if (harness.renders[i] == 0) missing++;
+            if (harness.renders[i] > 1) repeated++;
+        }
+        bool allDone = true;
+        for (int i = 0; i < tilesX * tilesY; ++i) allDone &= harness.tilePasses[i] == passes;
+
+        check(missing == 0, name + ": every tile renders every pass (" + std::to_string(missing) + " missing)");
+        check(repeated == 0, name + ": no tile renders a pass twice");
+        check(harness.outOfOrder == 0, name + ": tiles render their passes in order");
+        check(allDone, name + ": every tile ends on the last pass");
+        check(!harness.scheduler.isStopped(), name + ": running out of passes is not a stop");
+    }
+}
+
+// Stopping lets every thread out of a render with no last pass
+static void testStop() {
+    TileScheduler scheduler(4, 4, 4, 1);
+    scheduler.start(0, [](int) { return true; });
+    std::atomic<int> handedOut{ 0 };
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            int tile, pass;
+            while (scheduler.next(t, tile, pass)) {
+                if (++handedOut == 100) scheduler.stop();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    check(scheduler.isStopped(), "stop ends an endless render");
+}
+
+int main() {
+    // One pass is the non progressive render, a tile left out there is a hole in the image
+    testEveryPass(4, 2, 1, 16, 4);
+    testEveryPass(4, 2, 16, 16, 4);
+    testEveryPass(9, 7, 6, 8, 2);
+    testEveryPass(3, 3, 20, 4, 1);
+    testStop();
+    return failures;
+}
\ No newline at end of file